@@ -0,0 +1,222 @@
+/* cache.c
+ *
+ * Copyright 2015 Bob Parker <rlp1938@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+*/
+
+/* An opt in cache of generated output sets, like ccache. The key is a
+ * hash of everything generatecode() reads: the work files, the
+ * boilerplate files, the program name, -c columns, --cxx and gengo
+ * itself. A hit is restored by reflink, else hardlink, else copy, so
+ * a fleet sharing 1 cache dir generates each output set once.
+ * Cached files are read only. Hardlinked outputs share the cache's
+ * inode, so cacheunshare() must be used before writing any output,
+ * and the outputs users edit are only ever reflinked or copied.
+*/
+
+#include <stdio.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include "fileops.h"
+#include "stats.h"
+#include "cache.h"
+
+#ifndef PACKAGE_VERSION
+#define PACKAGE_VERSION "1.0"
+#endif
+
+static char cachedir[PATH_MAX - 32];	// room for /key/n
+static char keyhex[17];
+
+static unsigned long long fnv(unsigned long long h, const void *from,
+								size_t len);
+static int restoreone(const char *from, const char *to, int canlink);
+static void mkdirs(char *path);
+
+void cacheinit(const char *dir)
+{
+	/* dir is the cache dir or "" for $GENGO_CACHE_DIR, else
+	 * $HOME/.cache/gengo. */
+	if (dir && *dir == '/') {
+		snprintf(cachedir, sizeof cachedir, "%s", dir);
+	} else if (dir && *dir) {	// -g --multicall changes dir.
+		char cwd[PATH_MAX];
+		if (!getcwd(cwd, sizeof cwd)) {
+			perror("getcwd");
+			exit(EXIT_FAILURE);
+		}
+		if (snprintf(cachedir, sizeof cachedir, "%s/%s", cwd, dir)
+				>= (int)sizeof cachedir) {
+			fputs("cache dir name too long.\n", stderr);
+			exit(EXIT_FAILURE);
+		}
+	} else if (getenv("GENGO_CACHE_DIR")) {
+		snprintf(cachedir, sizeof cachedir, "%s", getenv("GENGO_CACHE_DIR"));
+	} else {
+		snprintf(cachedir, sizeof cachedir, "%s/.cache/gengo", getenv("HOME"));
+	}
+} // cacheinit()
+
+void cachekey(const char *progname, int cols, int cxx, int amalgamate,
+				int catalog, const char **inputs)
+{
+	/* Hashes the files named in inputs, NULL terminated, with the
+	 * settings that change what is generated from them. gengo's own
+	 * size and mtime stand in for its version between releases.
+	*/
+	unsigned long long h = 14695981039346656037ULL;
+	char buf[PATH_MAX];
+	struct stat sb;
+	int n = snprintf(buf, PATH_MAX, "gengo %s %s %d %d %d %d",
+						PACKAGE_VERSION, progname, cols, cxx, amalgamate,
+						catalog);
+	h = fnv(h, buf, n + 1);
+	if (stat("/proc/self/exe", &sb) == 0) {
+		h = fnv(h, &sb.st_size, sizeof sb.st_size);
+		h = fnv(h, &sb.st_mtim, sizeof sb.st_mtim);
+	}
+	for (; *inputs; inputs++) {
+		h = fnv(h, *inputs, strlen(*inputs) + 1);
+		fdata dat = readfile(*inputs, 0, 0);
+		if (!dat.from) {	// missing is not the same as empty.
+			h = fnv(h, "-", 1);
+			continue;
+		}
+		size_t len = dat.to - dat.from;
+		h = fnv(h, &len, sizeof len);
+		h = fnv(h, dat.from, len);
+		free(dat.from);
+	}
+	sprintf(keyhex, "%016llx", h);
+} // cachekey()
+
+int cacherestore(const char **outputs, int nedit)
+{
+	/* Puts the cached outputs for the current key in place, output i
+	 * from file i of the key's dir. The first nedit of them are the
+	 * user's to edit, and a chmod or write of a hardlink would change
+	 * the cache for everyone, so they are not hardlinked. Returns 0 on
+	 * a hit, else -1 with nothing changed.
+	*/
+	char from[PATH_MAX];
+	int i;
+	snprintf(from, PATH_MAX, "%s/%s", cachedir, keyhex);
+	if (direxists(from) == -1) return -1;
+	statsbegin("cache hit %s", keyhex);
+	for (i = 0; outputs[i]; i++) {
+		snprintf(from, PATH_MAX, "%s/%s/%d", cachedir, keyhex, i);
+		if (restoreone(from, outputs[i], i >= nedit) == -1) {
+			perror(outputs[i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	statsend();
+	return 0;
+} // cacherestore()
+
+void cachestore(const char **outputs)
+{
+	/* Copies the outputs just generated into the cache under the
+	 * current key. They are written to a temporary dir first and it
+	 * is renamed into place, so a concurrent gengo never sees part of
+	 * a set. If another gengo stored the same key first its set is
+	 * kept. Failing to store only costs the next run a miss.
+	*/
+	char tmp[PATH_MAX - 16], to[PATH_MAX];
+	int i;
+	statsbegin("cache store %s", keyhex);
+	mkdirs(strcpy(tmp, cachedir));
+	snprintf(tmp, sizeof tmp, "%s/tmp.XXXXXX", cachedir);
+	if (!mkdtemp(tmp)) {
+		perror(tmp);
+		statsend();
+		return;
+	}
+	chmod(tmp, 0755);	// the cache may be shared.
+	for (i = 0; outputs[i]; i++) {
+		fdata dat = readfile(outputs[i], 0, 1);
+		snprintf(to, PATH_MAX, "%s/%d", tmp, i);
+		writefile(to, dat.from, dat.to, "w");
+		chmod(to, 0444);
+		free(dat.from);
+	}
+	snprintf(to, PATH_MAX, "%s/%s", cachedir, keyhex);
+	if (rename(tmp, to) == -1) {	// EEXIST, ENOTEMPTY: lost a race.
+		while (i--) {
+			snprintf(to, PATH_MAX, "%s/%d", tmp, i);
+			unlink(to);
+		}
+		rmdir(tmp);
+	}
+	statsend();
+} // cachestore()
+
+void cacheunshare(const char *path)
+{
+	/* Removes path if it is a hardlink into the cache, so that writing
+	 * it does not change the cache. */
+	struct stat sb;
+	if (lstat(path, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_nlink > 1)
+		unlink(path);
+} // cacheunshare()
+
+unsigned long long fnv(unsigned long long h, const void *from,
+						size_t len)
+{	// FNV-1a, 64 bit.
+	const unsigned char *cp = from;
+	while (len--) h = (h ^ *cp++) * 1099511628211ULL;
+	return h;
+} // fnv()
+
+int restoreone(const char *from, const char *to, int canlink)
+{
+	/* Makes to a copy of from, a reflink where the filesystem can,
+	 * else a hardlink if canlink, else a plain copy. */
+	unlink(to);
+	int ifd = open(from, O_RDONLY);
+	if (ifd == -1) return -1;
+	int ofd = open(to, O_WRONLY | O_CREAT | O_EXCL, 0666);
+	if (ofd == -1) {
+		close(ifd);
+		return -1;
+	}
+	iocount.opens += 2;
+	int cloned = ioctl(ofd, FICLONE, ifd);
+	close(ofd);
+	close(ifd);
+	if (cloned == 0) return 0;
+	unlink(to);
+	if (canlink && link(from, to) == 0) return 0;
+	fdata dat = readfile(from, 0, 1);
+	writefile(to, dat.from, dat.to, "w");
+	free(dat.from);
+	return 0;
+} // restoreone()
+
+void mkdirs(char *path)
+{
+	/* mkdir -p path, path is modified on the way and restored. */
+	char *cp;
+	for (cp = path + 1; *cp; cp++) {
+		if (*cp != '/') continue;
+		*cp = '\0';
+		mkdir(path, 0777);
+		*cp = '/';
+	}
+	mkdir(path, 0777);
+} // mkdirs()
@@ -0,0 +1,31 @@
+/*
+ * cache.h
+ * Copyright 2015 Bob Parker <rlp1938@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+*/
+
+#ifndef _CACHE_H
+#define _CACHE_H
+
+void cacheinit(const char *dir);
+void cachekey(const char *progname, int cols, int cxx, int amalgamate,
+				int catalog, const char **inputs);
+int cacherestore(const char **outputs, int nedit);
+void cachestore(const char **outputs);
+void cacheunshare(const char *path);
+
+#endif
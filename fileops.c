@@ -19,6 +19,8 @@
 */
 
 #include "fileops.h"
+#include "stats.h"
+#include "lineinput.h"
 
 fdata readfile(const char *filename, off_t extra, int fatal)
 {
@@ -44,6 +46,7 @@ fdata readfile(const char *filename, off_t extra, int fatal)
         perror(filename);
         exit(EXIT_FAILURE);
     }
+    iocount.opens++;
 
     from = malloc(sb.st_size + extra);
     if (!(from)) {
@@ -59,6 +62,7 @@ fdata readfile(const char *filename, off_t extra, int fatal)
 		perror(filename);
 		exit(EXIT_FAILURE);
 	}
+	iocount.bytesread += bytesread;
     to = from + bytesread + extra;
     // zero the extra space
     memset(from+bytesread, 0, to-(from+bytesread));
@@ -75,6 +79,7 @@ FILE *dofopen(const char *fn, const char *fmode)
 		perror(fn);
 		exit(EXIT_FAILURE);
 	}
+	iocount.opens++;
 	return fpx;
 } // dofopen()
 
@@ -119,6 +124,7 @@ void writefile(const char *to_write, const char *from, const char *to,
 			perror(to_write);
 			exit(EXIT_FAILURE);
 		}
+		iocount.opens++;
 	}
 	ssize_t towrite = to - from;
 	ssize_t written = write(ofd, from, towrite);
@@ -128,6 +134,8 @@ void writefile(const char *to_write, const char *from, const char *to,
 		perror(to_write);
 		exit(EXIT_FAILURE);
 	}
+	iocount.writes++;
+	iocount.byteswritten += written;
 	if (ofd != 1) close(ofd);
 } // writefile()
 
@@ -223,27 +231,25 @@ int getans(const char *prompt, const char *choices)
 	*/
 
 	char c;
-	char buf[10];
 	char promptbuf[NAME_MAX];
 	char ucchoices[NAME_MAX];
 	memset(ucchoices, 0, NAME_MAX);
 	size_t l = strlen(choices);
 	size_t i;
-	for (i = 0; i < l; i++) {
-		ucchoices[i] = choices[i];
+	for (i = 0; i < l && i < NAME_MAX - 1; i++) {
+		ucchoices[i] = toupper((unsigned char)choices[i]);
 	}
-	fputs(prompt, stdout);
+	dowrite(1, (char *)prompt);
 	sprintf(promptbuf, "Enter one of [%s] :", choices);
 	while (1) {
-		fputs(promptbuf, stdout);
-		char *cp = fgets(buf, 10, stdin);
+		char *cp = inputline(promptbuf);
 		if (!cp) {
-			perror("fgets");
+			fputs("Unexpected end of input.\n", stderr);
 			exit(EXIT_FAILURE);
 		}
 
-		c = toupper(buf[0]);
-		if (strchr(choices, c)) break;
+		c = toupper((unsigned char)cp[0]);
+		if (c && strchr(ucchoices, c)) break;
 	}
 	return c;
 } // getans()
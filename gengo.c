@@ -30,11 +30,35 @@
 #include <linux/limits.h>
 #include <libgen.h>
 #include <fcntl.h>
-#include <readline/readline.h>
-#include <readline/history.h>
+#include <errno.h>
+#include <locale.h>
+#include <wchar.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <time.h>
 #include "fileops.h"
 #include "firstrun.h"
 #include "getoptions.h"
+#include "stats.h"
+#include "lineinput.h"
+#include "cache.h"
+#include "template.h"
+
+// the outputs of generatecode()
+#define GEN_MAIN	1
+#define GEN_HDR	2
+#define GEN_SRC	4
+#define GEN_MAKE	8
+#define GEN_ALL	(GEN_MAIN | GEN_HDR | GEN_SRC | GEN_MAKE)
+#define ENVMAX	256	// options in the environment table.
+
+// the work files written by getoptdata()
+static const char *workfiles[] = {
+	"helpTXT.c", "usageTXT.c", "declTXT.h", "defltTXT.c",
+	"socodeTXT.c", "locodeTXT.c", "lostructTXT.c", "noargsTXT.c",
+	"constrTXT.c", "lazyTXT.c", "lazyTXT.h", NULL
+};
 
 typedef struct tagpair {
 	char *opntag;
@@ -42,17 +66,103 @@ typedef struct tagpair {
 } tagpair;
 
 int ioflag;
+int cxxmode;	// generate C++ instead of C.
+int amalgamate;	// getoptions.c goes into getoptions.h.
+int catalog;	// the help goes to progname.C.help, not getoptions.c.
+
+typedef struct profcount {
+	char name[NAME_MAX];	// --longname, or -c for a short only.
+	unsigned long n;
+} profcount;
+profcount *profile;	// option use counts from --profile.
+int nprofile;
+char *profilefile;
+
+typedef struct ruleset {	// the rules of constrTXT.c
+	int n;	// 0 if there is no constrTXT.c
+	char bitchars[NAME_MAX];	// optbitchars[]
+	char kinds[NAME_MAX];	// optrulekind[]
+	unsigned long long (*mask)[2][ENVMAX / 64];	// optrulemask[]
+} ruleset;
 
 char *getoptionsBP_C, *getoptionsBP_H, *mainBP_C, *MakefileBP_;
+// with --watch, the makefile the first -g chose, kept for the rest.
+static char *watchmakefile;
+char *workfilesBP_, *multicallBP_, *coldstartBP_;
+
+// the variables of the work file templates in workfilesBP.
+static const char *const optvars[] = {
+	"optstr", "char", "long", "var", "type", "deflt", "code", "count",
+	"hasarg", "index", "list", "display", "help", "lazy", NULL
+};
+enum { OV_OPTSTR, OV_CHAR, OV_LONG, OV_VAR, OV_TYPE, OV_DEFLT, OV_CODE,
+	OV_COUNT, OV_HASARG, OV_INDEX, OV_LIST, OV_DISPLAY, OV_HELP, OV_LAZY,
+	OV_N };
+
+// the variables of multicallBP, the last 3 per tool.
+static const char *const mcvars[] = {
+	"suite", "amalgamate", "tool", "ident", "dir", NULL
+};
+enum { MC_SUITE, MC_AMALGAMATE, MC_TOOL, MC_IDENT, MC_DIR, MC_N };
+
+// the variables of coldstartBP, the last per command line.
+static const char *const csvars[] = {
+	"progname", "cxx", "amalgamate", "catalog", "args", NULL
+};
+enum { CS_PROGNAME, CS_CXX, CS_AMALGAMATE, CS_CATALOG, CS_ARGS, CS_N };
 
 static void getoptdata(char *useroptstring);
+static const char *tracecount(const char *code);
+static char **newoptrec(char ***recs, int *nrecs);
+static void setoptvar(char **rec, int var, const char *fmt, ...);
+static void writeworkfiles(const char *optstr, char **recs, int nrecs);
 static void getmultilines(char *multi, const char *display,
 							unsigned maxlen, int wanteol);
+static void getconstraints(const char *shorts, char **lonames,
+							int *lobits, int nlo, int nbits);
+static void getlistdata(char *name, char *type, char *deflt,
+							char *code);
+static void getlazydata(char *name, char *type, char *deflt,
+							char *code);
 static void getuserinput(const char *prompt, char *reply);
-static void generatecode(const char *progname, int cols);
+static void generatecode(const char *progname, int cols, int what);
+static void generatecached(const char *progname, int cols);
+static void generatetool(const char *progname, int cols, int cached);
+static void generatecoldstart(const char *progname);
+static void loadrules(ruleset *rs);
+static int argbit(const char *arg, const ruleset *rs, fdata lostruct);
+static int rulesbroken(const ruleset *rs, const int *bits, char *in,
+						int nargs);
+static void generatemulticall(const char *suite, char **dirs, int ndirs,
+								int cols, int cached);
+static int mccmp(const void *a, const void *b);
+static char *makefilename(void);
+static void watchcode(const char *progname, int cols, int stats);
+static int dependents(const char *filename);
+static void selftest(char **specs, int nspecs, int jobs);
+static int selftestone(const char *specdir, const char *scratch);
+static char **sampleargs(char *posargs, const char *file);
+static void report(int pertext);
+static long reportcompile(const char *ccbase, const char *scratch,
+							const char *from, const char *to);
+static void reportfmt(char *buf, size_t size, const char *fmt, ...);
+static size_t reporthelptext(const char *from, const char *to);
+static int lint(void);
+static int lintdups(char **names, int nnames, const char *fmt);
+static int lintcmp(const void *a, const void *b);
 static void fatal(const char *msg);
 static fdata fmtusagelines(const char *progname, char *from, char *to);
-static fdata fmthelplines(char *from, char *to, int cols);
+static fdata fmthelplines(char *from, char *to, FILE *fpcat);
+static fdata fmtenvtab(const char *progname, char *from, char *to);
+static int envchar(int c);
+static int shortenv(char names[][NAME_MAX], char *chars, int *hasarg,
+							int max);
+static fdata fmtserial(char *from, char *to);
+static int parsedecl(const char *line, char *type, char *name);
+static fdata fmttypeincludes(char *from, char *to);
+static void cstrwrite(FILE *fpo, const char *from, const char *to);
+static void cstrread(FILE *fpo, const char *from, const char *to);
+static size_t u8width(const char *from, const char *to);
 static fdata bracketsearch(char *from, char *to, char *opn, char *cls);
 static tagpair maketags(char *tagname);
 static void boilerplateinit(const char *bpfilename,
@@ -60,36 +170,87 @@ static void boilerplateinit(const char *bpfilename,
 							char *tagname);
 static void boilerplateappend(const char *targetfilename,
 								char *tagname);
+static fdata boilerplatesection(char *tagname);
 static void boilerplatedeinit(void);
 static void appenduserfile(const char *userfilename,
 							const char *targetfilename);
+static void loadprofile(const char *path);
+static void lostructname(fdata lostruct, int n, int c, char *name);
+static void blockname(const char *blk, fdata lostruct, char *name);
+static unsigned long profweight(const char *blk, fdata lostruct);
+static fdata hotfirst(fdata in, const char *start, fdata lostruct,
+						int *order);
+static void appendhot(const char *userfilename,
+						const char *targetfilename, const char *start,
+						fdata lostruct);
+static fdata fmtoptorder(fdata lostruct);
+static void amalgamatefiles(const char *hdrfile, const char *srcfile);
+static fdata cxxfilter(fdata ufdata);
+static fdata memreplace(fdata in, const char *old, const char *new);
 
 int main(int argc, char **argv)
 {
 	options_t opts = process_options(argc, argv);
+	// help text display widths are measured as UTF-8.
+	if (!setlocale(LC_CTYPE, "C.UTF-8")) setlocale(LC_CTYPE, "");
 
 	char *pn = strdup(basename(argv[0]));
 	if (checkfirstrun(pn) == -1) {
 		fputs("firstrun\n", stdout);
 		firstrun(pn, "getoptionsBP.c", "getoptionsBP.h", "mainBP.c",
-					"MakefileBP", NULL);
+					"MakefileBP", "getoptionsBP.cpp", "getoptionsBP.hpp",
+					"mainBP.cpp", "MakefilecppBP", "workfilesBP",
+					"multicallBP", "coldstartBP", NULL);
 	}
 
 	// name the boiler plate files.
 	{
 		char buf[PATH_MAX];
 		char *home = getenv("HOME");
-		sprintf(buf, "%s/.config/%s/%s", home, pn, "getoptionsBP.c");
+		cxxmode = opts.cxx;
+		amalgamate = opts.amalgamate;
+		catalog = opts.catalog;
+		char *bpsrc = (cxxmode) ? "getoptionsBP.cpp" : "getoptionsBP.c";
+		char *bphdr = (cxxmode) ? "getoptionsBP.hpp" : "getoptionsBP.h";
+		char *bpmain = (cxxmode) ? "mainBP.cpp" : "mainBP.c";
+		char *bpmake = (cxxmode) ? "MakefilecppBP" : "MakefileBP";
+		sprintf(buf, "%s/.config/%s/%s", home, pn, bpsrc);
+		// the C++ files are newer than some users' config dirs.
+		if (cxxmode && fileexists(buf) == -1)
+			firstrun(pn, bpsrc, bphdr, bpmain, bpmake, NULL);
 		getoptionsBP_C = strdup(buf);
-		sprintf(buf, "%s/.config/%s/%s", home, pn, "getoptionsBP.h");
+		sprintf(buf, "%s/.config/%s/%s", home, pn, bphdr);
 		getoptionsBP_H = strdup(buf);
-		sprintf(buf, "%s/.config/%s/%s", home, pn, "mainBP.c");
+		sprintf(buf, "%s/.config/%s/%s", home, pn, bpmain);
 		mainBP_C = strdup(buf);
-		sprintf(buf, "%s/.config/%s/%s", home, pn, "MakefileBP");
+		sprintf(buf, "%s/.config/%s/%s", home, pn, bpmake);
 		MakefileBP_ = strdup(buf);
+		sprintf(buf, "%s/.config/%s/workfilesBP", home, pn);
+		// as are the work file templates.
+		if (opts.inter && fileexists(buf) == -1)
+			firstrun(pn, "workfilesBP", NULL);
+		workfilesBP_ = strdup(buf);
+		sprintf(buf, "%s/.config/%s/multicallBP", home, pn);
+		if (opts.multicall && fileexists(buf) == -1)
+			firstrun(pn, "multicallBP", NULL);
+		multicallBP_ = strdup(buf);
+		sprintf(buf, "%s/.config/%s/coldstartBP", home, pn);
+		if (opts.coldstart && fileexists(buf) == -1)
+			firstrun(pn, "coldstartBP", NULL);
+		coldstartBP_ = strdup(buf);
 	}
 	free(pn);
 
+	if (opts.selftest) {	// specs are dirs of work files.
+		if (!argv[optind]) {
+			fputs("No work file directories provided.\n", stderr);
+			dohelp(EXIT_FAILURE);
+		}
+		selftest(argv + optind, argc - optind, opts.jobs);
+	}
+
+	if (opts.lint) exit((lint()) ? EXIT_FAILURE : EXIT_SUCCESS);
+
 	// make sure that I have set inter or gen but not both.
 	if ((opts.inter == 0 && opts.gen == 0) || (opts.inter == 1 && opts.gen == 1)) {
 		fprintf(stderr,
@@ -104,6 +265,7 @@ int main(int argc, char **argv)
 			fputs("No options string provided.\n", stderr);
 			dohelp(EXIT_FAILURE);
 		}
+		inputinit(opts.record, opts.replay);
 		getoptdata(argv[optind]);
 	} else {	// writing program files.
 		if (!argv[optind]) {
@@ -111,10 +273,31 @@ int main(int argc, char **argv)
 			dohelp(EXIT_FAILURE);
 		}
 		char *progname = strdup(argv[optind]);
-		generatecode(progname, opts.cols);
+		statsinit(opts.stats);
+		if (opts.profile) {
+			profilefile = opts.profile;
+			loadprofile(profilefile);
+		}
+		if (opts.cache) cacheinit(opts.cache);
+		if (opts.multicall) {	// the rest of the args are tool dirs.
+			generatemulticall(progname, argv + optind + 1,
+								argc - optind - 1, opts.cols,
+								opts.cache != NULL);
+			statsreport(stderr);
+			exit(EXIT_SUCCESS);
+		}
+		if (opts.watch) watchmakefile = makefilename();
+		generatetool(progname, opts.cols, opts.cache != NULL);
+		if (opts.coldstart) generatecoldstart(progname);
+		statsreport(stderr);
+		if (opts.report) report(opts.report == 2);
+		if (opts.watch) watchcode(progname, opts.cols, opts.stats);
 		free(progname);
 	}
 
+	free(multicallBP_);
+	free(coldstartBP_);
+	free(workfilesBP_);
 	free(mainBP_C);
 	free(getoptionsBP_H);
 	free(getoptionsBP_C);
@@ -134,33 +317,29 @@ void getoptdata(char *useroptstring)
 	strcpy(optstringout, ":h");
 	strcat(optstringout, useroptstring);
 
-	// open work files, next 3 always wanted
-	FILE *fphelp = dofopen("helpTXT.c", "w");
 	FILE *fpusage = dofopen("usageTXT.c", "w");
-	FILE *fpdeflt = dofopen("defltTXT.c", "w");
-
-	// next 4 work files opended conditionally
-	FILE *fpsocode = NULL;
-	FILE *fplocode = NULL;
-	FILE *fplostruct = NULL;
-	FILE *fpdecl = NULL;
-
-	// Must initialise some stuff independently of user later input.
-	fprintf(fpdeflt, "\tstatic const char optstr[] = \"%s\";\n\n",
-				optstringout);
-	fputs("\toptions_t opts = { 0 };\n", fpdeflt);
-	fputs("\n/* helptext */\n\n", fphelp);
+	/* The other work files are written from workfilesBP at the end,
+	 * from 1 record of optvars[] values per option. */
+	char **recs = NULL;
+	int nrecs = 0;
 
 
 	len = strlen(optstringout);
 
+	/* The bit of each option in optseen[] for getconstraints(), short
+	 * options in optstring order, then long options only by index. */
+	char shorts[NAME_MAX];
+	int nshort = 0;
+	for (idx = 1; idx < len; idx++) {
+		if (optstringout[idx] != ':') shorts[nshort++] = optstringout[idx];
+	}
+	shorts[nshort] = '\0';
+	char *lonames[ENVMAX];
+	int lobits[ENVMAX];
+	int nlo = 0;
+
 	int loidx = 1;	/* 0 has already been consumed by
 					{"help", 0, 0, 'h'}, */
-	// formats
-	char *declfmt = "%s %s;\n";
-	char *defltfmt = "\topts.%s = %s;\n";
-	char *codefmt =
-			"\t\t\tcase \'%c\':\n\t\t\t\topts.%s %s;\n\t\t\t\tbreak;\n";
 	// result buffers
 	char namebuf[NAME_MAX];
 	char typebuf[NAME_MAX];
@@ -172,7 +351,6 @@ void getoptdata(char *useroptstring)
 
 	for (idx = 2; idx < len; idx++)  {	// ignore ":h"
 		unsigned char c = optstringout[idx];
-		if (!fpsocode) fpsocode = dofopen("socodeTXT.c", "w");
 		if (c == ':') continue;	// user is responsible for any optarg.
 		if (!isalnum(c)) {
 			fprintf(stderr, "Option char: %c is not in [a-zA-Z0-9]\n"
@@ -186,9 +364,12 @@ void getoptdata(char *useroptstring)
 		char *prompt = "For this option will you:\n"
 		"Use a single variable to which you assign a value (1)\n"
 		"Use a char pointer and strdup optarg onto it (2)\n"
-		"Or do something else, possibly affecting several variables\n"
-		"when the option is selected (3).\n";
-		char ans = getans(prompt, "123");
+		"Do something else, possibly affecting several variables\n"
+		"when the option is selected (3)\n"
+		"Collect every optarg given in a list (4)\n"
+		"Or keep the optarg and convert it the first time it is read\n"
+		"(5).\n";
+		char ans = getans(prompt, "12345");
 		switch (ans) {
 			case '1':
 				// Option variable name.
@@ -227,25 +408,31 @@ void getoptdata(char *useroptstring)
 				strcpy(codebuf, "/* FIXME Enter C code for variable(s) "
 				"used by option here.*/");
 				break;
+			case '4':
+				getlistdata(namebuf, typebuf, defltbuf, codebuf);
+				break;
+			case '5':
+				getlazydata(namebuf, typebuf, defltbuf, codebuf);
+				break;
 			}
 
+			char **rec = newoptrec(&recs, &nrecs);
+			setoptvar(rec, OV_CHAR, "%c", c);
+			setoptvar(rec, OV_HASARG, "%d",
+				(idx+1 < len && optstringout[idx+1] == ':') ? 1 : 0);
 			// Is there a long option name?
 			loname[0] = '\0';
 			getuserinput(
 						"Enter long option name or <return> for none:",
 							loname);
 			if (strlen(loname)) {
-				if (!fplostruct)
-					fplostruct = dofopen("lostructTXT.c", "w");
-				// I can set up and write the long options struct
-				char losbuf[NAME_MAX];
-				int rqd = (idx+1 < len && optstringout[idx+1] == ':')
-							? 1 : 0;
-				sprintf(losbuf, "\t\t\t{\"%s\",\t%d,\t0,\t\'%c\'},\n",
-						loname, rqd, c);
-				fputs(losbuf, fplostruct);
+				setoptvar(rec, OV_LONG, "%s", loname);
 				// how the options will display
 				sprintf(displayopt, "-%c, --%s", c, loname);
+				if (nlo < ENVMAX) {
+					lobits[nlo] = strchr(shorts, c) - shorts;
+					lonames[nlo++] = strdup(loname);
+				}
 				loidx++;
 			} else {
 				sprintf(displayopt, "-%c", c);
@@ -253,13 +440,19 @@ void getoptdata(char *useroptstring)
 
 		// get help line(s) for this option.
 		getmultilines(helpbuf, "help text", NAME_MAX, 1);
-		fprintf(fphelp, "\n%s\n", displayopt);
-		fprintf(fphelp, "\n%s\n", helpbuf);
+		setoptvar(rec, OV_DISPLAY, "%s", displayopt);
+		setoptvar(rec, OV_HELP, "%s", helpbuf);
 
-		// write other workfiles
-		// declaration
-		if (!fpdecl) fpdecl = dofopen("declTXT.h", "w");
-		fprintf(fpdecl, declfmt, typebuf, namebuf);
+		// the rest of the record.
+		setoptvar(rec, OV_VAR, "%s", namebuf);
+		setoptvar(rec, OV_TYPE, "%s", typebuf);
+		if (ans == '5') {	// the code is for opt_<var>().
+			setoptvar(rec, OV_LAZY, "%s", codebuf);
+		} else {
+			setoptvar(rec, OV_CODE, "%s", codebuf);
+			setoptvar(rec, OV_COUNT, "%s", tracecount(codebuf));
+		}
+		if (ans == '4') setoptvar(rec, OV_LIST, "1");
 		/* Set default value, conditionally.
 		 * By default every object in the options_t struct is 0 | NULL
 		 * so only explicitly set each object if it's value is
@@ -271,10 +464,8 @@ void getoptdata(char *useroptstring)
 		int iszero = ((strlen(defltbuf) == 1) &&
 						(strchr(defltbuf, '0')));
 		if (!(iszero || isnull)) {
-			fprintf(fpdeflt, defltfmt, namebuf, defltbuf);
+			setoptvar(rec, OV_DEFLT, "%s", defltbuf);
 		}
-		// C code when selected
-		fprintf(fpsocode, codefmt, c, namebuf, codebuf);
 	} // for(idx ...)
 
 	// Check for any long options not paired with short ones.
@@ -284,26 +475,25 @@ void getoptdata(char *useroptstring)
 					loname);
 		if (strlen(loname) == 0 ) break;
 
-		// I have 1 or more unpaired option so ensure rqd files opened.
-		if (!fplocode) fplocode = dofopen("locodeTXT.c", "w");
-		if (!fplostruct) fplostruct = dofopen("lostructTXT.c", "w");
 		char argans = getans("Does this option want an argument", "Yn");
 		int wantsarg = ( argans == 'Y')? 1 : 0;
-		// I can write the long options struct now.
-		fprintf(fplostruct, "\t\t{%s,\t%d,\t0,\t0 },\n", loname,
-					wantsarg);
+		char **rec = newoptrec(&recs, &nrecs);
+		setoptvar(rec, OV_LONG, "%s", loname);
+		setoptvar(rec, OV_HASARG, "%d", wantsarg);
+		setoptvar(rec, OV_INDEX, "%d", loidx);
 
-		// options for display in dohelp()
-		sprintf(displayopt, "\n%s\n", loname);
 		char *lofmt = "Processing option %s\n"
 					"For this option will you:\n"
 			"Use a single variable to which you assign a value (1)\n"
 			"Use a char pointer and strdup optarg onto it (2)\n"
-		"Or do something else, possibly affecting several variables\n"
-		"when the option is selected (3).\n";
-		char lobuf[NAME_MAX];
+		"Do something else, possibly affecting several variables\n"
+		"when the option is selected (3)\n"
+		"Collect every optarg given in a list (4)\n"
+		"Or keep the optarg and convert it the first time it is read\n"
+		"(5).\n";
+		char lobuf[PATH_MAX];
 		sprintf(lobuf, lofmt, loname);
-		char ans = getans(lobuf, "123");
+		char ans = getans(lobuf, "12345");
 		switch (ans)
 		{
 			case '1':
@@ -343,21 +533,44 @@ void getoptdata(char *useroptstring)
 				strcpy(codebuf, "/*FIXME Enter C code for variable(s) "
 				"used by option here.*/");
 				break;
+			case '4':
+				getlistdata(namebuf, typebuf, defltbuf, codebuf);
+				break;
+			case '5':
+				getlazydata(namebuf, typebuf, defltbuf, codebuf);
+				break;
 		} // switch(ans)
-		// now write the workfiles
-		// declaration
-		if (!fpdecl) fpdecl = dofopen("declTXT.h", "w");
-		fprintf(fpdecl, declfmt, typebuf, namebuf);
-		// set default value
-		fprintf(fpdeflt, defltfmt, namebuf, defltbuf);
-		// C code when selected, not the same as short options
-		char *codelofmt = "\t\tcase %d:\n\t\t\t%s %s;\n\t\t\tbreak;\n";
-		fprintf(fplocode, codelofmt, loidx, namebuf, codebuf);
+		// the rest of the record.
+		setoptvar(rec, OV_VAR, "%s", namebuf);
+		setoptvar(rec, OV_TYPE, "%s", typebuf);
+		if (ans == '5') {	// the code is for opt_<var>().
+			setoptvar(rec, OV_LAZY, "%s", codebuf);
+		} else {
+			setoptvar(rec, OV_CODE, "%s", codebuf);
+			setoptvar(rec, OV_COUNT, "%s", tracecount(codebuf));
+		}
+		// set default value, a list starts empty.
+		if (ans == '4') setoptvar(rec, OV_LIST, "1");
+		else setoptvar(rec, OV_DEFLT, "%s", defltbuf);
+		if (nlo < ENVMAX) {
+			lobits[nlo] = nshort + loidx;
+			lonames[nlo++] = strdup(loname);
+		}
 
 		// increment the long options index
 		loidx++;
 	} // while(1)
 
+	writeworkfiles(optstringout, recs, nrecs);
+	for (idx = 0; idx < (unsigned)nrecs * OV_N; idx++) free(recs[idx]);
+	free(recs);
+
+	// Conflicts, requirements and oneof groups between options.
+	if (nshort + loidx > ENVMAX) fatal("Too many options to constrain.");
+	fputs(eols, stdout);
+	getconstraints(shorts, lonames, lobits, nlo, nshort + loidx);
+	while (nlo) free(lonames[--nlo]);
+
 	// Usage strings.
 	char usagebuf[NAME_MAX];
 	/* the literal "progname" will be replaced by the actual program
@@ -368,13 +581,7 @@ void getoptdata(char *useroptstring)
 	fputs(usagebuf, fpusage);
 	fputs("\n", fpusage);	// empty line marks end of usage lines.
 
-	if (fphelp) fclose(fphelp);
 	if (fpusage) fclose(fpusage);
-	if (fpdecl) fclose(fpdecl);
-	if (fpdeflt) fclose(fpdeflt);
-	if (fpsocode) fclose(fpsocode);
-	if (fplocode) fclose(fplocode);
-	if (fplostruct) fclose(fplostruct);
 
 	free(optstringout);
 
@@ -386,28 +593,28 @@ void getoptdata(char *useroptstring)
 	int noargs = strtol(noabuf, NULL, 10);
 	if (noargs == 0) return;	// done
 	FILE *fpnoarg = fopen("noargsTXT.c", "w");
-	fputs("\t//Non-option arguments\n", fpnoarg);
+	/* All of them are checked by 1 call of checkargs(), 1 char per
+	 * argument says what kind it is. */
+	char kinds[NAME_MAX];
 	int i;
-	for (i=0; i < noargs; i++) {
-		// Does the argv[optind] exist?
-		fputs("\tif(!argv[optind]) {\n", fpnoarg);
+	for (i=0; i < noargs && i < NAME_MAX - 1; i++) {
 		const char * kind_prompt = "What kind of object is required?\n"
-			"Dir(1), File(2), String(3) or something else(4)\n";
-		char ansno = getans(kind_prompt, "1234");
-		char *rqd[] = {
-			"dir",
-			"file",
-			"string",
-			"/* Insert name of required object here. */"
-		};
-		char *fmt = "\t\tfputs(\"No %s provided.\", stderr);\n";
-		fprintf(fpnoarg, fmt, rqd[ansno - 49]);
-		/* 48 difference between '1' and 1, and then the list (rqd) is
+			"Dir(1), File(2), String(3), something else(4) or\n"
+			"all of the remaining arguments are files(5)\n";
+		char ansno = getans(kind_prompt, "12345");
+		/* 48 difference between '1' and 1, and then the list is
 		 * zero based so deduct another 1. */
-		fputs("\t\tdohelp(1);\n", fpnoarg);
-		fputs("\t};\n", fpnoarg);
-		fputs("\toptind++;\n", fpnoarg);
+		kinds[i] = "dfs?F"[ansno - 49];
+		if (ansno == '5') {
+			i++;
+			break;	// nothing can follow.
+		}
 	}
+	kinds[i] = '\0';
+	fputs("\t//Non-option arguments, d dir, f file, s string, ? other,"
+			"\n\t// F all the remaining arguments are files.\n", fpnoarg);
+	fprintf(fpnoarg, "\toptind = checkargs(argc, argv, optind, \"%s\");\n",
+				kinds);
 	fclose(fpnoarg);
 	if (havefixme) {
 		char *advice =
@@ -419,29 +626,205 @@ void getoptdata(char *useroptstring)
 
 } // getoptdata()
 
+void getconstraints(const char *shorts, char **lonames, int *lobits,
+						int nlo, int nbits)
+{	/* Asks for the conflicts, requires and oneof rules between options
+	 * and writes them to constrTXT.c as optrule masks of the bits
+	 * that optmark() sets in optseen[]. Options are short option
+	 * chars or long option names. Nothing is written if there are no
+	 * rules.
+	*/
+	const char *prompt = "Enter option constraints, empty line to quit.\n"
+		"  x conflicts y ...   x can not be used with any of y ...\n"
+		"  x requires y ...    x can only be used with all of y ...\n"
+		"  oneof x y ...       exactly one of x y ... must be used\n"
+		"x and y are short option chars or long option names.\n";
+	int words = (nbits + 63) / 64;
+	char *kinds, *masks, *msgs;
+	size_t klen, mlen, glen;
+	FILE *fpk = open_memstream(&kinds, &klen);
+	FILE *fpm = open_memstream(&masks, &mlen);
+	FILE *fpg = open_memstream(&msgs, &glen);
+	if (!fpk || !fpm || !fpg) {
+		perror("open_memstream");
+		exit(EXIT_FAILURE);
+	}
+	int nrules = 0;
+	while (1) {
+		char line[NAME_MAX];
+		getuserinput(prompt, line);
+		if (strlen(line) == 0) break;
+		char *toks[NAME_MAX / 2], *save;
+		int n = 0;
+		char *tok = strtok_r(line, " \t", &save);
+		while (tok && n < NAME_MAX / 2) {
+			toks[n++] = tok;
+			tok = strtok_r(NULL, " \t", &save);
+		}
+		/* oneof x y ..., everything in mask[0]
+		 * x conflicts|requires y ..., x in mask[0], y ... in mask[1] */
+		char kind = 0;
+		if (n >= 3 && strcmp(toks[0], "oneof") == 0) kind = 'o';
+		else if (n >= 3 && strcmp(toks[1], "conflicts") == 0) kind = 'c';
+		else if (n >= 3 && strcmp(toks[1], "requires") == 0) kind = 'r';
+		if (!kind) {
+			fputs("Not a constraint, try again.\n", stderr);
+			continue;
+		}
+		unsigned long long mask[2][ENVMAX / 64];
+		memset(mask, 0, sizeof mask);
+		char msg[NAME_MAX * 2];
+		strcpy(msg, (kind == 'o') ? "use exactly one of" : "");
+		int t, bad = 0;
+		for (t = (kind == 'o'); t < n && !bad; t++) {
+			if (t == 1 && kind != 'o') {
+				strcat(msg, (kind == 'c') ? " can not be used with"
+							: " can only be used with");
+				continue;
+			}
+			int bit = -1, i;
+			const char *cp = (strlen(toks[t]) == 1)
+							? strchr(shorts, *toks[t]) : NULL;
+			if (cp) bit = cp - shorts;
+			for (i = 0; bit == -1 && i < nlo; i++) {
+				if (strcmp(toks[t], lonames[i]) == 0) bit = lobits[i];
+			}
+			if (bit == -1) {
+				fprintf(stderr, "No such option: %s\n", toks[t]);
+				bad = 1;
+				break;
+			}
+			mask[(kind != 'o' && t > 0)][bit / 64] |= 1ULL << (bit % 64);
+			sprintf(msg + strlen(msg), "%s%s%s", (t) ? " " : "",
+					(cp) ? "-" : "--", toks[t]);
+		}
+		if (bad) continue;
+		int w, s;
+		fputc(kind, fpk);
+		fputs("  {", fpm);
+		for (s = 0; s < 2; s++) {
+			fputs(" {", fpm);
+			for (w = 0; w < words; w++)
+				fprintf(fpm, " 0x%llxULL,", mask[s][w]);
+			fputs(" },", fpm);
+		}
+		fputs(" },\n", fpm);
+		fprintf(fpg, "  \"%s\",\n", msg);
+		nrules++;
+	}
+	fclose(fpk);
+	fclose(fpm);
+	fclose(fpg);
+	if (nrules) {
+		FILE *fpo = dofopen("constrTXT.c", "w");
+		fprintf(fpo, "\n#define OPTWORDS %d\n"
+				"static const char optbitchars[] = \"%s\";\n"
+				"static unsigned long long optseen[OPTWORDS];\n"
+				"static const char optrulekind[] = \"%s\";\n"
+				"static const unsigned long long "
+				"optrulemask[][2][OPTWORDS] = {\n%s"
+				"  { { 0 }, { 0 } }\n};\n"
+				"static const char *const optrulemsg[] = {\n%s"
+				"  NULL\n};\n", words, shorts, kinds, masks, msgs);
+		fclose(fpo);
+	}
+	free(kinds);
+	free(masks);
+	free(msgs);
+} // getconstraints()
+
+const char *tracecount(const char *code)
+{	/* The gtrace counter for option code that copies or converts
+	 * optarg, or an empty string if it does neither. */
+	if (strstr(code, "strdup")) return "allocs";
+	if (strstr(code, "optarg") && strcmp(code, "optarg") != 0)
+		return "conversions";
+	return "";
+} // tracecount()
+
+char **newoptrec(char ***recs, int *nrecs)
+{	/* Appends a record of OV_N empty values to *recs, returns it. */
+	*recs = realloc(*recs, (*nrecs + 1) * OV_N * sizeof(char *));
+	if (!*recs) {
+		perror("newoptrec");
+		exit(EXIT_FAILURE);
+	}
+	char **rec = *recs + *nrecs * OV_N;
+	memset(rec, 0, OV_N * sizeof(char *));
+	(*nrecs)++;
+	return rec;
+} // newoptrec()
+
+void setoptvar(char **rec, int var, const char *fmt, ...)
+{	/* Sets variable var of rec, replacing any value, to the printf
+	 * of fmt. */
+	va_list ap;
+	va_start(ap, fmt);
+	free(rec[var]);
+	if (vasprintf(&rec[var], fmt, ap) == -1) {
+		perror("setoptvar");
+		exit(EXIT_FAILURE);
+	}
+	va_end(ap);
+} // setoptvar()
+
+void writeworkfiles(const char *optstr, char **recs, int nrecs)
+{	/* Renders each section of workfilesBP to the work file it is
+	 * named for, over the option records recs. Files that come out
+	 * empty are not written.
+	*/
+	fdata bp = readfile(workfilesBP_, 0, 1);
+	const char *globals[OV_N] = { NULL };
+	globals[OV_OPTSTR] = optstr;
+	char *cp = bp.from;
+	while (cp < bp.to) {
+		char *tag = memmem(cp, bp.to - cp, "//<", 3);
+		if (!tag) break;
+		char *eot = memchr(tag, '>', bp.to - tag);
+		cp = tag + 3;
+		if (!eot || (tag > bp.from && tag[-1] != '\n') || *cp == '/')
+			continue;
+		char name[NAME_MAX];
+		sprintf(name, "%.*s", (int)((eot - cp < 70) ? eot - cp : 70), cp);
+		if (strchr(name, '/')) fatal("workfilesBP: not a file name");
+		tagpair tp = maketags(name);
+		fdata part = bracketsearch(tag, bp.to, tp.opntag, tp.clstag);
+		tpl t = tplcompile(part.from, part.to, optvars);
+		char *resbuf;
+		size_t reslen;
+		FILE *fpres = open_memstream(&resbuf, &reslen);
+		tplrender(&t, fpres, globals, (const char *const *)recs, nrecs);
+		fclose(fpres);
+		if (reslen) writefile(name, resbuf, resbuf + reslen, "w");
+		free(resbuf);
+		tplfree(&t);
+		cp = part.to;
+	}
+	free(bp.from);
+} // writeworkfiles()
+
 void getmultilines(char *multi, const char *display, unsigned maxlen,
 					int wanteol)
 {	/* Inform user using text at display and return many lines '\n'
 	separated in multi. */
 
-	/* Using the C library functions (man 3 ...) gives me unwanted
-	 * optimisations that end up with output prompts and inputs all
-	 * over the place. Using system calls (man 2 ...) allows me to
-	 * control the order of prompts and reads as I need them to be.
-	 * */
-	char result[PATH_MAX], longprompt[NAME_MAX], work[NAME_MAX];
+	char result[PATH_MAX], longprompt[NAME_MAX];
 	char *fmt = "Input %s.\nUse as many lines as required. An empty"
 	" line ends input.\nInput will be truncated at %d characters.\n";
 	sprintf(longprompt, fmt, display, maxlen);
 	dowrite(1, longprompt);
 	result[0] = 0;
+	size_t len = 0;
 	while(1) {
-		doread(0, NAME_MAX, work);
-		char *cp = strchr(work, '\n');
-		if (cp) *cp = '\0';
-		if (strlen(work) == 0) break;
-		if (wanteol) strcat(work, "\n");	// terminate input with EOL
-		strcat(result, work);
+		char *work = inputline(NULL);
+		if (!work || strlen(work) == 0) break;
+		size_t wl = strlen(work);
+		if (len + wl + 2 < PATH_MAX) {
+			strcpy(result + len, work);
+			len += wl;
+			if (wanteol) result[len++] = '\n';	// terminate with EOL
+			result[len] = '\0';
+		}
 	}
 	// silent failure if we go over length.
 	if (strlen(result) >= maxlen ) {
@@ -451,113 +834,1408 @@ void getmultilines(char *multi, const char *display, unsigned maxlen,
 	strcpy(multi, result);
 } // getmultilines()
 
+void getlistdata(char *name, char *type, char *deflt, char *code)
+{	/* Choice (4), an optlist that grows geometrically in
+	 * optlistpush() and holds either pointers into argv or copies of
+	 * each optarg. It starts empty so deflt is "0".
+	*/
+	getuserinput("Enter variable name: ", name);
+	strcpy(type, "optlist");
+	strcpy(deflt, "0");
+	char ans = getans("Keep pointers into argv rather than copies",
+						"Yn");
+	strcpy(code, (ans == 'Y') ? "optarg" : "strdup(optarg)");
+} // getlistdata()
+
+void getlazydata(char *name, char *type, char *deflt, char *code)
+{	/* Choice (5), the optarg is kept in name_arg and opt_name() runs
+	 * code the first time it is called, with s the optarg, the default
+	 * or NULL and v the address of name, then returns name. Only runs
+	 * that read the option pay for converting it.
+	*/
+	getuserinput("Enter variable name: ", name);
+	getuserinput("Enter variable type: ", type);
+	getuserinput("Enter the default optarg as a C string, or <return>"
+					" for none: ", deflt);
+	getuserinput("Enter C code that sets *v from s, the optarg, which"
+					" is NULL\nif there is no default: ", code);
+} // getlazydata()
+
 void getuserinput(const char *prompt, char *reply)
 {
-	char *buf = readline(prompt);
-	strcpy(reply, buf);
-	free(buf);
+	/* reply is at least NAME_MAX bytes. */
+	char *buf = inputline(prompt);
+	if (!buf) {
+		fputs("Unexpected end of input.\n", stderr);
+		exit(EXIT_FAILURE);
+	}
+	snprintf(reply, NAME_MAX, "%s", buf);
 } // getuserinput()
 
-void generatecode(const char *progname, int cols)
+// what generatecode() writes in place of constrTXT.c
+static const char noconstraints[] =
+	"\n#define OPTWORDS 1\n"
+	"static const char optbitchars[] = \"\";\n"
+	"static unsigned long long optseen[OPTWORDS];\n"
+	"static const char optrulekind[] = \"\";\n"
+	"static const unsigned long long optrulemask[][2][OPTWORDS] = {\n"
+	"  { { 0 }, { 0 } }\n};\n"
+	"static const char *const optrulemsg[] = {\n"
+	"  NULL\n};\n";
+
+void generatecode(const char *progname, int cols, int what)
 {	/* Writes the files getoptions.h, getoptions.c and main.c
 	 * Source files are boilerplate, getoptionsBP.h, getoptionsBP.c,
 	 * mainBP.c and MakefileBP located in
 	 * $HOME/.config/genco/boilerplate/
 	 * and the purpose written:
 	 * helpTXT.c usageTXT.c declTXT.h defltTXT.c socodeTXT.c locodeTXT.c
-	 * lostructTXT.c noargsTXT.c
+	 * lostructTXT.c noargsTXT.c constrTXT.c
+	 * what is the GEN_* set of outputs to write.
+	 * In cxxmode the C++ boilerplate is used and the outputs are
+	 * getoptions.hpp, getoptions.cpp and main.cpp. With amalgamate
+	 * getoptions.c ends up in getoptions.h, so the two go together.
 	*/
+	char *mainfile = (cxxmode) ? "main.cpp" : "main.c";
+	char *hdrfile = (cxxmode) ? "getoptions.hpp" : "getoptions.h";
+	char *srcfile = (cxxmode) ? "getoptions.cpp" : "getoptions.c";
+	char namebuf[NAME_MAX];
+	sprintf(namebuf, "%s.%s", progname, (cxxmode) ? "cpp" : "c");
+	if (amalgamate && (what & (GEN_HDR | GEN_SRC)))
+		what |= GEN_HDR | GEN_SRC;
+	// don't write through a hardlink into the cache.
+	cacheunshare(hdrfile);
+	cacheunshare(srcfile);
+	cacheunshare("Makefile.gdb");
+
 	// 1. generate main.c
-	// a) write the preamble.
-	boilerplateinit(mainBP_C, "main.c", "preamble");
-	// b) append non-option argument processing
-	appenduserfile("noargsTXT.c", "main.c");
-	// c) append the rest of main.c
-	boilerplateappend("main.c", "tail");
-	boilerplatedeinit();
+	if (what & GEN_MAIN) {
+		// a) write the preamble.
+		boilerplateinit(mainBP_C, mainfile, "preamble");
+		// b) append non-option argument processing
+		appenduserfile("noargsTXT.c", mainfile);
+		// c) append the rest of main.c
+		boilerplateappend(mainfile, "tail");
+		boilerplatedeinit();
+		// d) main.c must be renamed to <progname>.c or my brain dead
+		// makefile will fail to link the 2 object files.
+		if (rename(mainfile, namebuf) == -1) {
+			perror(namebuf);
+			exit(EXIT_FAILURE);
+		}
+		// e) main.c is where the amalgamated parser is compiled, it
+		// includes getoptions.h first for the feature macros there.
+		if (amalgamate) {
+			char inc[NAME_MAX];
+			sprintf(inc, "#include \"%s\"\n", hdrfile);
+			const char *impl = "#define GETOPTIONS_IMPLEMENTATION\n";
+			fdata mdat = memreplace(readfile(namebuf, 0, 1), inc, "");
+			char *first = memmem(mdat.from, mdat.to - mdat.from,
+									"\n#include", 9);
+			first = (first) ? first + 1 : mdat.from;
+			writefile(namebuf, mdat.from, first, "w");
+			writefile(namebuf, impl, impl + strlen(impl), "a");
+			writefile(namebuf, inc, inc + strlen(inc), "a");
+			writefile(namebuf, first, mdat.to, "a");
+			free(mdat.from);
+		}
+	}
 
 	// 2. generate getoptions.h
-	// a) write the preamble.
-	boilerplateinit(getoptionsBP_H, "getoptions.h", "preamble");
-	// b) append the user's variable declarations.
-	appenduserfile("declTXT.h", "getoptions.h");
-	// c) append the tail end of the BP file.
-	boilerplateappend("getoptions.h", "tail");
-	boilerplatedeinit();
+	if (what & GEN_HDR) {
+		// a) write the preamble.
+		boilerplateinit(getoptionsBP_H, hdrfile, "preamble");
+		// b) the headers the user's variable types need, no more.
+		{
+			statsbegin("fmttypeincludes");
+			fdata part;
+			fdata wfdat = readfile("declTXT.h", 0, 0);
+			part = fmttypeincludes(wfdat.from, wfdat.to);
+			writefile(hdrfile, part.from, part.to, "a");
+			free (part.from);
+			free(wfdat.from);
+			statsend();
+		}
+		// c) optlist and the top of options_t.
+		boilerplateappend(hdrfile, "optionstype");
+		// d) append the user's variable declarations.
+		appenduserfile("declTXT.h", hdrfile);
+		// e) close options_t and declare the opt_<var>() accessors.
+		boilerplateappend(hdrfile, "optionsend");
+		appenduserfile("lazyTXT.h", hdrfile);
+		// f) append the tail end of the BP file.
+		boilerplateappend(hdrfile, "tail");
+		boilerplatedeinit();
+	}
 
 	// 3. write getoptions.c
-	// a) write the preamble.
-	boilerplateinit(getoptionsBP_C, "getoptions.c", "preamble");
-	// b) set up the help text mess. At the top is usage.
-	// b.1 usage.
-	if (fileexists("usageTXT.c") == 0) {
-		fdata part;
-		fdata wfdat = readfile("usageTXT.c", 0, 1);
-		part = fmtusagelines(progname, wfdat.from, wfdat.to);
-		writefile("getoptions.c", part.from, part.to, "a");
-		free(wfdat.from);
-		free (part.from);
-	}
-	// b.2 The common help lines, -h, --help, in the BP file
-	boilerplateappend("getoptions.c", "fixedoptions");
-	// b.3) append user created help lines.
-	if (fileexists("helpTXT.c") == 0) {
-		fdata part;
-		fdata wfdat = readfile("helpTXT.c", 0, 1);
-		part = fmthelplines(wfdat.from, wfdat.to, cols);
-		writefile("getoptions.c", part.from, part.to, "a");
-		free (part.from);
-		free(wfdat.from);
-	}
-	// b.4 // terminator for help lines.
-	boilerplateappend("getoptions.c", "endoptions");
-
-	// c) append defaults initialisation.
-	appenduserfile("defltTXT.c", "getoptions.c");
-
-	// d) long option processing
-	// d.1) write the top of the loop
-	boilerplateappend("getoptions.c", "golongwshortpre");
-	// c.2) append any option struct(s) user may have made.
-	appenduserfile("lostructTXT.c", "getoptions.c");
-	// c.3) finish off long options structs etc
-	boilerplateappend("getoptions.c", "golongwshortpost");
-	// c.4) write top of long options only loop
-	boilerplateappend("getoptions.c", "glongonlypre");
-	// c.5) write any long options only C code that user may have made.
-	appenduserfile("locodeTXT.c", "getoptions.c");
-	// c.6) finish the long options only C code loop
-	boilerplateappend("getoptions.c", "glongonlypost");
-	// c.7) begin the short options
-	boilerplateappend("getoptions.c", "glshortspre");
-	// c.8) append user made short option code.
-	appenduserfile("socodeTXT.c", "getoptions.c");
-	// c.9) finish off short options
-	boilerplateappend("getoptions.c", "glshortspost");
-	// c.10) complete the file
-	boilerplateappend("getoptions.c", "tail");
-	boilerplatedeinit();
+	if (what & GEN_SRC) {
+		// the long option names for the hottest first orders.
+		fdata lostruct = readfile("lostructTXT.c", 0, 0);
+		// a) write the preamble.
+		boilerplateinit(getoptionsBP_C, srcfile, "preamble");
+		// b) set up the help text mess. At the top is usage. With
+		// catalog, it goes to the C catalog as well, as plain text.
+		char *catbuf = NULL;
+		size_t catlen = 0;
+		FILE *fpcat = NULL;
+		if (catalog && !(fpcat = open_memstream(&catbuf, &catlen))) {
+			perror("open_memstream");
+			exit(EXIT_FAILURE);
+		}
+		// b.1 usage.
+		if (fileexists("usageTXT.c") == 0) {
+			statsbegin("fmtusagelines");
+			fdata part;
+			fdata wfdat = readfile("usageTXT.c", 0, 1);
+			part = fmtusagelines(progname, wfdat.from, wfdat.to);
+			writefile(srcfile, part.from, part.to, "a");
+			if (fpcat) cstrread(fpcat, part.from, part.to);
+			free(wfdat.from);
+			free (part.from);
+			statsend();
+		}
+		// b.2 The common help lines, -h, --help, in the BP file
+		boilerplateappend(srcfile, "fixedoptions");
+		if (fpcat) {
+			fdata part = boilerplatesection("fixedoptions");
+			cstrread(fpcat, part.from, part.to);
+		}
+		// b.3) append user created help lines, if any.
+		{
+			statsbegin("fmthelplines");
+			fdata part;
+			fdata wfdat = readfile("helpTXT.c", 0, 0);
+			part = fmthelplines(wfdat.from, wfdat.to, fpcat);
+			writefile(srcfile, part.from, part.to, "a");
+			free (part.from);
+			free(wfdat.from);
+			statsend();
+		}
+		// b.3.1) the name of the catalogs, for -DGENGO_CATALOG.
+		{
+			fdata part = boilerplatesection("endhelp");
+			part.from = strndup(part.from, part.to - part.from);
+			part.to = part.from + strlen(part.from);
+			part = memreplace(part, "progname", progname);
+			writefile(srcfile, part.from, part.to, "a");
+			free(part.from);
+		}
+		if (fpcat) {
+			fclose(fpcat);
+			char catname[NAME_MAX];
+			snprintf(catname, NAME_MAX, "%s.C.help", progname);
+			writefile(catname, catbuf, catbuf + catlen, "w");
+			free(catbuf);
+		}
+		// b.4 OPTORIG(), long_options[] may be in profile order.
+		{
+			statsbegin("fmtoptorder");
+			fdata part;
+			part = fmtoptorder(lostruct);
+			writefile(srcfile, part.from, part.to, "a");
+			free (part.from);
+			statsend();
+		}
+		// b.5 // start of process_options().
+		boilerplateappend(srcfile, "endoptions");
 
-	// 4. generate a minimal makefile.
-	// a) main.c must be renamed to <progname>.c or my brain dead
-	// makefile will fail to link the 2 object files.
-	char namebuf[NAME_MAX];
-	sprintf(namebuf, "%s.c", progname);
-	if (rename("main.c", namebuf) == -1) {
-		perror(namebuf);
-		exit(EXIT_FAILURE);
+		// c) append defaults initialisation.
+		appenduserfile("defltTXT.c", srcfile);
+
+		// d) long option processing
+		// d.1) write the top of the loop
+		boilerplateappend(srcfile, "golongwshortpre");
+		// c.2) append any option struct(s) user may have made.
+		appendhot("lostructTXT.c", srcfile, "\t\t\t{", lostruct);
+		// c.3) finish off long options structs etc
+		boilerplateappend(srcfile, "golongwshortpost");
+		// c.4) write top of long options only loop
+		boilerplateappend(srcfile, "glongonlypre");
+		// c.5) write any long options only C code that user may have
+		// made.
+		appendhot("locodeTXT.c", srcfile, "\t\t\t\t\tcase ",
+					lostruct);
+		// c.6) finish the long options only C code loop
+		boilerplateappend(srcfile, "glongonlypost");
+		// c.7) begin the short options
+		boilerplateappend(srcfile, "glshortspre");
+		// c.8) append user made short option code.
+		appendhot("socodeTXT.c", srcfile, "\t\t\tcase '", lostruct);
+		// c.9) finish off short options
+		boilerplateappend(srcfile, "glshortspost");
+		// c.10) the width to wrap help to when the terminal can't tell.
+		{
+			statsbegin("%s helpcols", srcfile);
+			char colsbuf[80];
+			sprintf(colsbuf, "\nstatic const int helpcols = %d;\n",
+						cols);
+			writefile(srcfile, colsbuf,
+						colsbuf + strlen(colsbuf), "a");
+			statsend();
+		}
+		// c.11) the table of environment variables, from the long
+		// options.
+		{
+			statsbegin("fmtenvtab");
+			fdata part;
+			fdata wfdat = readfile("lostructTXT.c", 0, 0);
+			part = fmtenvtab(progname, wfdat.from, wfdat.to);
+			writefile(srcfile, part.from, part.to, "a");
+			free (part.from);
+			free(wfdat.from);
+			statsend();
+		}
+		// c.12) the option constraints, none if no constrTXT.c.
+		if (fileexists("constrTXT.c") == 0) {
+			appenduserfile("constrTXT.c", srcfile);
+		} else {
+			writefile(srcfile, (char *)noconstraints, (char *)
+						noconstraints + strlen(noconstraints), "a");
+		}
+		// c.13) options_serialize() and options_deserialize().
+		{
+			statsbegin("fmtserial");
+			fdata part;
+			fdata wfdat = readfile("declTXT.h", 0, 0);
+			part = fmtserial(wfdat.from, wfdat.to);
+			writefile(srcfile, part.from, part.to, "a");
+			free (part.from);
+			free(wfdat.from);
+			statsend();
+		}
+		// c.14) complete the file
+		boilerplateappend(srcfile, "tail");
+		boilerplatedeinit();
+		// c.15) the opt_<var>() accessors.
+		appenduserfile("lazyTXT.c", srcfile);
+		free(lostruct.from);
+		// d) one header, stb style.
+		if (amalgamate) amalgamatefiles(hdrfile, srcfile);
 	}
-	// b) don't clobber a Makefile that is there by some other means.
+
+	// 4. generate a minimal makefile.
+	if (!(what & GEN_MAKE)) return;
+	statsbegin("Makefile");
+	// a) don't clobber a Makefile that is there by some other means.
 	fdata bpdat;
-	char *mf = "Makefile";
-	if (fileexists(mf) == 0) mf = "Makefile.gdb";
+	char *mf = makefilename();
 	bpdat = readfile(MakefileBP_, 1, 1);	// extra byte for '\0'.
 	*(bpdat.to - 1) = '\0';	// bpdat.from now a C string.
-	// c) generate the makefile, the BP file is a format statement,
-	sprintf(namebuf, bpdat.from, progname, progname);
-	writefile(mf, namebuf, namebuf+ strlen(namebuf), "w");
+	// b) generate the makefile, the BP file is a format statement,
+	// too long now for namebuf.
+	char *mkbuf = malloc(strlen(bpdat.from) + 2 * strlen(progname) + 1);
+	if (!mkbuf) {
+		perror("Makefile");
+		exit(EXIT_FAILURE);
+	}
+	sprintf(mkbuf, bpdat.from, progname, progname);
+	fdata mkdat;
+	mkdat.from = mkbuf;
+	mkdat.to = mkbuf + strlen(mkbuf);
+	// c) getoptions.o is gone when amalgamated.
+	if (amalgamate) mkdat = memreplace(mkdat, " getoptions.o", "");
+	// d) the help is in the catalog.
+	if (catalog) mkdat = memreplace(mkdat, "FLAGS = ",
+									"FLAGS = -DGENGO_CATALOG ");
+	writefile(mf, mkdat.from, mkdat.to, "w");
+	free(mkdat.from);
+	free(bpdat.from);
+	statsend();
 } // generatecode()
 
+void generatecached(const char *progname, int cols)
+{	/* generatecode() of all the outputs through the cache. The key is
+	 * made from everything generatecode() reads, a hit is restored in
+	 * place of generating and a miss is generated then stored.
+	*/
+	char mainfile[NAME_MAX], catname[NAME_MAX];
+	sprintf(mainfile, "%s.%s", progname, (cxxmode) ? "cpp" : "c");
+	snprintf(catname, NAME_MAX, "%s.C.help", progname);
+	const char *outputs[6];
+	int o = 0;
+	// the 2 the user edits first, they are restored as copies.
+	outputs[o++] = mainfile;
+	outputs[o++] = makefilename();
+	outputs[o++] = (cxxmode) ? "getoptions.hpp" : "getoptions.h";
+	if (!amalgamate)
+		outputs[o++] = (cxxmode) ? "getoptions.cpp" : "getoptions.c";
+	if (catalog) outputs[o++] = catname;
+	outputs[o] = NULL;
+	const char *inputs[sizeof workfiles / sizeof workfiles[0] + 5];
+	int i, n = 0;
+	inputs[n++] = getoptionsBP_C;
+	inputs[n++] = getoptionsBP_H;
+	inputs[n++] = mainBP_C;
+	inputs[n++] = MakefileBP_;
+	for (i = 0; workfiles[i]; i++) inputs[n++] = workfiles[i];
+	if (profilefile) inputs[n++] = profilefile;
+	inputs[n] = NULL;
+	statsbegin("cache key");
+	cachekey(progname, cols, cxxmode, amalgamate, catalog, inputs);
+	statsend();
+	if (cacherestore(outputs, 2) == 0) return;
+	generatecode(progname, cols, GEN_ALL);
+	cachestore(outputs);
+} // generatecached()
+
+void generatetool(const char *progname, int cols, int cached)
+{	/* -g for the work files in the current dir, once lint() passes,
+	 * through the cache if cached. */
+	statsbegin("lint");
+	int lintfail = lint();
+	statsend();
+	if (lintfail) {
+		fprintf(stderr, "%d error(s) in the work files, nothing "
+				"generated.\n", lintfail);
+		exit(EXIT_FAILURE);
+	}
+	if (cached) generatecached(progname, cols);
+	else generatecode(progname, cols, GEN_ALL);
+} // generatetool()
+
+void generatemulticall(const char *suite, char **dirs, int ndirs,
+						int cols, int cached)
+{	/* Generates the tool in each of dirs, ndirs of them, named for its
+	 * dir, then in the current dir <suite>.c, the main() of a multi-call
+	 * binary of all the tools, and its makefile from multicallBP.
+	*/
+	if (cxxmode) fatal("--multicall: the tools must be C.");
+	if (!ndirs) fatal("--multicall: no tool dirs provided.");
+	char **recs = calloc(ndirs * MC_N, sizeof(char *));
+	if (!recs) {
+		perror("generatemulticall");
+		exit(EXIT_FAILURE);
+	}
+	int i;
+	for (i = 0; i < ndirs; i++) {
+		char **rec = recs + i * MC_N;
+		char *dir = strdup(dirs[i]);
+		size_t len = strlen(dir);
+		while (len > 1 && dir[len - 1] == '/') dir[--len] = '\0';
+		char *slash = strrchr(dir, '/');
+		rec[MC_DIR] = dir;
+		rec[MC_TOOL] = strdup((slash) ? slash + 1 : dir);
+		rec[MC_IDENT] = strdup(rec[MC_TOOL]);
+		char *cp;
+		for (cp = rec[MC_IDENT]; *cp; cp++)
+			if (!isalnum((unsigned char)*cp)) *cp = '_';
+	}
+	// tools[] in the suite's main() is bsearch()ed.
+	qsort(recs, ndirs, MC_N * sizeof(char *), mccmp);
+	for (i = 1; i < ndirs; i++) {
+		char **prev = recs + (i - 1) * MC_N, **rec = recs + i * MC_N;
+		if (strcmp(prev[MC_IDENT], rec[MC_IDENT]) == 0) {
+			fprintf(stderr, "--multicall: %s and %s are 1 tool name.\n",
+					prev[MC_DIR], rec[MC_DIR]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// 1. each tool, as -g in its dir would.
+	int here = open(".", O_RDONLY | O_DIRECTORY);
+	if (here == -1) {
+		perror(".");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < ndirs; i++) {
+		char **rec = recs + i * MC_N;
+		if (chdir(rec[MC_DIR]) == -1) {
+			perror(rec[MC_DIR]);
+			exit(EXIT_FAILURE);
+		}
+		generatetool(rec[MC_TOOL], cols, cached);
+		if (fchdir(here) == -1) {
+			perror("fchdir");
+			exit(EXIT_FAILURE);
+		}
+	}
+	close(here);
+
+	// 2. the suite's main() and makefile.
+	fdata bp = readfile(multicallBP_, 0, 1);
+	const char *globals[MC_N] = { NULL };
+	globals[MC_SUITE] = suite;
+	globals[MC_AMALGAMATE] = (amalgamate) ? "1" : NULL;
+	char mainfile[NAME_MAX];
+	sprintf(mainfile, "%s.c", suite);
+	char *outputs[] = { "main", mainfile, "Makefile", makefilename() };
+	for (i = 0; i < 4; i += 2) {
+		tagpair tp = maketags(outputs[i]);
+		fdata part = bracketsearch(bp.from, bp.to, tp.opntag, tp.clstag);
+		tpl t = tplcompile(part.from, part.to, mcvars);
+		FILE *fpo = dofopen(outputs[i + 1], "w");
+		tplrender(&t, fpo, globals, (const char *const *)recs, ndirs);
+		fclose(fpo);
+		tplfree(&t);
+	}
+	free(bp.from);
+	for (i = 0; i < ndirs * MC_N; i++) free(recs[i]);
+	free(recs);
+} // generatemulticall()
+
+int mccmp(const void *a, const void *b)
+{	/* qsort() order of multicall records, by tool name. */
+	return strcmp(((char *const *)a)[MC_TOOL], ((char *const *)b)[MC_TOOL]);
+} // mccmp()
+
+void generatecoldstart(const char *progname)
+{	/* Writes coldstart.c and coldstart.mk from coldstartBP, and
+	 * coldstartTXT if there is none, its command lines: none, -h, each
+	 * option alone with a dummy argument if it takes one, and as many
+	 * of them as go together, each with the dummy non-option
+	 * arguments. Under the rules of constrTXT.c a line gets the
+	 * options its options require and 1 of each oneof group it has
+	 * none of, and is left out if it still breaks a rule or is the
+	 * same as a line before it.
+	*/
+	statsbegin("coldstart");
+	char posargs[NAME_MAX];
+	char mainfile[NAME_MAX];
+	sprintf(mainfile, "%s.%s", progname, (cxxmode) ? "cpp" : "c");
+	char **optargs = sampleargs(posargs, mainfile);
+	int nargs = 0, i, j;
+	while (optargs[nargs]) nargs++;
+	ruleset rs;
+	loadrules(&rs);
+	fdata lostruct = readfile("lostructTXT.c", 0, 0);
+	int *bits = malloc((nargs + 1) * sizeof(int));
+	// the options of each line, none, each alone, all, then a scratch.
+	char *lines = calloc((nargs + 3) * (nargs + 1), 1);
+	char **recs = calloc((nargs + 3) * CS_N, sizeof(char *));
+	if (!bits || !lines || !recs) {
+		perror("generatecoldstart");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < nargs; i++) bits[i] = argbit(optargs[i], &rs, lostruct);
+	free(lostruct.from);
+	char *all = lines + (nargs + 1) * (nargs + 1);
+	char *try = all + nargs + 1;
+	for (i = 0; i < nargs; i++) {
+		lines[(i + 1) * (nargs + 1) + i] = 1;
+		memcpy(try, all, nargs);
+		try[i] = 1;
+		if (!rulesbroken(&rs, bits, try, nargs)) memcpy(all, try, nargs);
+	}
+	int nruns = 0, nopts = 0;
+	for (i = 0; i < nargs; i++) nopts += all[i];
+	for (i = 0; i < nargs + 2; i++) {
+		char *in = lines + i * (nargs + 1);
+		if (i == 1) recs[nruns++ * CS_N + CS_ARGS] = strdup("-h");
+		if ((i == nargs + 1 && nopts < 2) || rulesbroken(&rs, bits, in,
+							nargs)) continue;
+		for (j = 0; j < i && memcmp(lines + j * (nargs + 1), in, nargs)
+				!= 0; j++) ;
+		if (j < i) continue;	// the same as line j.
+		char args[NAME_MAX] = "";
+		for (j = 0; j < nargs; j++) {
+			if (!in[j] || strlen(args) + strlen(optargs[j]) + 2
+					>= NAME_MAX) continue;
+			if (*args) strcat(args, " ");
+			strcat(args, optargs[j]);
+		}
+		if (asprintf(&recs[nruns++ * CS_N + CS_ARGS], "%s%s", args,
+						(*args) ? posargs : posargs + (*posargs != 0))
+				== -1) {
+			perror("generatecoldstart");
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 0; i < nargs; i++) free(optargs[i]);
+	free(optargs);
+	free(bits);
+	free(lines);
+	free(rs.mask);
+
+	fdata bp = readfile(coldstartBP_, 0, 1);
+	const char *globals[CS_N] = { NULL };
+	globals[CS_PROGNAME] = progname;
+	globals[CS_CXX] = (cxxmode) ? "1" : NULL;
+	globals[CS_AMALGAMATE] = (amalgamate) ? "1" : NULL;
+	globals[CS_CATALOG] = (catalog) ? "1" : NULL;
+	char *outputs[] = { "coldstart.c", "coldstart.mk", "coldstartTXT" };
+	for (i = 0; i < 3; i++) {
+		// the command lines are the user's to edit.
+		if (i == 2 && fileexists(outputs[i]) == 0) continue;
+		tagpair tp = maketags(outputs[i]);
+		fdata part = bracketsearch(bp.from, bp.to, tp.opntag, tp.clstag);
+		tpl t = tplcompile(part.from, part.to, csvars);
+		FILE *fpo = dofopen(outputs[i], "w");
+		tplrender(&t, fpo, globals, (const char *const *)recs, nruns);
+		fclose(fpo);
+		tplfree(&t);
+	}
+	free(bp.from);
+	for (i = 0; i < nruns * CS_N; i++) free(recs[i]);
+	free(recs);
+	statsend();
+} // generatecoldstart()
+
+void loadrules(ruleset *rs)
+{	/* rs from the constrTXT.c in the current dir, as getconstraints()
+	 * wrote it, rs->n 0 if there is none. */
+	memset(rs, 0, sizeof *rs);
+	fdata dat = readfile("constrTXT.c", 1, 0);
+	if (!dat.from) return;
+	*(dat.to - 1) = '\0';
+	int words = 0, r, s, w;
+	char *cp = strstr(dat.from, "#define OPTWORDS ");
+	if (cp) sscanf(cp, "#define OPTWORDS %d", &words);
+	cp = strstr(dat.from, "optbitchars[] = \"");
+	if (cp) sscanf(cp, "optbitchars[] = \"%254[^\"]", rs->bitchars);
+	cp = strstr(dat.from, "optrulekind[] = \"");
+	if (cp) sscanf(cp, "optrulekind[] = \"%254[^\"]", rs->kinds);
+	int n = strlen(rs->kinds);
+	rs->mask = calloc(n + 1, sizeof *rs->mask);
+	if (!rs->mask) {
+		perror("loadrules");
+		exit(EXIT_FAILURE);
+	}
+	cp = strstr(dat.from, "optrulemask");
+	for (r = 0; cp && r < n && words <= ENVMAX / 64; r++) {
+		for (s = 0; s < 2; s++) {
+			for (w = 0; w < words && cp; w++) {
+				cp = strstr(cp, "0x");
+				if (cp) rs->mask[r][s][w] = strtoull(cp, &cp, 16);
+			}
+		}
+	}
+	if (cp) rs->n = r;
+	free(dat.from);
+} // loadrules()
+
+int argbit(const char *arg, const ruleset *rs, fdata lostruct)
+{	/* The bit in optseen[] of arg, "-c ..." or "--name ...", from
+	 * optbitchars[] or the line of name in lostructTXT.c, as optmark()
+	 * sets it. -1 if it has none. */
+	if (arg[1] != '-') {
+		const char *cp = strchr(rs->bitchars, arg[1]);
+		return (cp) ? cp - rs->bitchars : -1;
+	}
+	char want[NAME_MAX + 2], name[NAME_MAX + 2];
+	sscanf(arg, "%256s", want);
+	int n;
+	for (n = 1; ; n++) {
+		lostructname(lostruct, n, 0, name);
+		if (!name[0]) return -1;
+		if (strcmp(name, want) == 0)
+			return (int)strlen(rs->bitchars) + n;
+	}
+} // argbit()
+
+int rulesbroken(const ruleset *rs, const int *bits, char *in, int nargs)
+{	/* Whether the options in[i] of the nargs whose bits are bits[i]
+	 * break a rule of rs, as optcheck() would find, after adding to
+	 * in[] what a requires rule wants and the first of a oneof group
+	 * that has none in.
+	*/
+	unsigned long long seen[ENVMAX / 64];
+	int i, r, w, more = 1, broken = 0;
+	while (more) {
+		more = 0;
+		memset(seen, 0, sizeof seen);
+		for (i = 0; i < nargs; i++)
+			if (in[i] && bits[i] >= 0)
+				seen[bits[i] / 64] |= 1ULL << (bits[i] % 64);
+		for (r = 0; r < rs->n; r++) {
+			int a = 0, missing = 0;
+			for (w = 0; w < ENVMAX / 64; w++) {
+				a |= (seen[w] & rs->mask[r][0][w]) != 0;
+				missing |= (rs->mask[r][1][w] & ~seen[w]) != 0;
+			}
+			int none = !a;
+			for (i = 0; i < nargs; i++) {
+				if (in[i] || bits[i] < 0) continue;
+				unsigned long long bit = 1ULL << (bits[i] % 64);
+				if ((rs->kinds[r] == 'r' && a && missing
+						&& (rs->mask[r][1][bits[i] / 64] & bit))
+					|| (rs->kinds[r] == 'o' && none
+						&& (rs->mask[r][0][bits[i] / 64] & bit))) {
+					in[i] = 1;
+					more = 1;
+					none = 0;
+				}
+			}
+		}
+	}
+	for (r = 0; r < rs->n; r++) {
+		int a = 0, b = 0, missing = 0, n = 0;
+		for (w = 0; w < ENVMAX / 64; w++) {
+			a |= (seen[w] & rs->mask[r][0][w]) != 0;
+			b |= (seen[w] & rs->mask[r][1][w]) != 0;
+			missing |= (rs->mask[r][1][w] & ~seen[w]) != 0;
+			n += __builtin_popcountll(seen[w] & rs->mask[r][0][w]);
+		}
+		if ((rs->kinds[r] == 'c' && a && b)
+			|| (rs->kinds[r] == 'r' && a && missing)
+			|| (rs->kinds[r] == 'o' && n != 1)) broken++;
+	}
+	return broken;
+} // rulesbroken()
+
+char *makefilename(void)
+{	/* The makefile to write, Makefile.gdb so as not to clobber a
+	 * Makefile that is there by some other means. Under --watch the
+	 * Makefile is there by the first -g, so that name is kept. */
+	if (watchmakefile) return watchmakefile;
+	return (fileexists("Makefile") == 0) ? "Makefile.gdb" : "Makefile";
+} // makefilename()
+
+void watchcode(const char *progname, int cols, int stats)
+{	/* Waits for changes to the work files in the current dir or to the
+	 * boilerplate files and regenerates only the outputs that depend
+	 * on the changed files. Never returns.
+	 * Editors often save by renaming a new file over the old one, so
+	 * the directories are watched rather than the files.
+	*/
+	int ifd = inotify_init1(IN_CLOEXEC);
+	if (ifd == -1) {
+		perror("inotify_init1");
+		exit(EXIT_FAILURE);
+	}
+	char bpdir[PATH_MAX];
+	strcpy(bpdir, getoptionsBP_C);
+	uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE;
+	if (inotify_add_watch(ifd, ".", mask) == -1 ||
+		inotify_add_watch(ifd, dirname(bpdir), mask) == -1) {
+		perror("inotify_add_watch");
+		exit(EXIT_FAILURE);
+	}
+	fprintf(stderr, "Watching work files and %s\n", bpdir);
+	char evbuf[4096]
+		__attribute__ ((aligned(__alignof__(struct inotify_event))));
+	while (1) {
+		/* Collect the changes until things are quiet for 50ms, a
+		 * save is often several events. */
+		int what = 0;
+		struct pollfd pfd = { ifd, POLLIN, 0 };
+		int timeout = -1;
+		while (1) {
+			int ready = poll(&pfd, 1, timeout);
+			if (ready == -1 && errno == EINTR) continue;
+			if (ready == -1) {
+				perror("poll");
+				exit(EXIT_FAILURE);
+			}
+			if (ready == 0) break;	// quiet since the last change.
+			ssize_t len = read(ifd, evbuf, sizeof evbuf);
+			if (len == -1 && errno == EINTR) continue;
+			if (len == -1) {
+				perror("inotify read");
+				exit(EXIT_FAILURE);
+			}
+			char *cp = evbuf;
+			while (cp < evbuf + len) {
+				struct inotify_event *ev = (struct inotify_event *)cp;
+				if (ev->len) what |= dependents(ev->name);
+				cp += sizeof(struct inotify_event) + ev->len;
+			}
+			if (what) timeout = 50;
+		}
+		statsinit(stats);
+		generatecode(progname, cols, what);
+		statsreport(stderr);
+		fprintf(stderr, "Regenerated:%s%s%s%s\n",
+				(what & GEN_MAIN) ? " main" : "",
+				(what & GEN_HDR) ? " header" : "",
+				(what & GEN_SRC) ? " getoptions" : "",
+				(what & GEN_MAKE) ? " Makefile" : "");
+	}
+} // watchcode()
+
+int dependents(const char *filename)
+{	/* The GEN_* set of outputs that are made from filename. The
+	 * boilerplate of the other language makes nothing.
+	*/
+	static const struct {
+		const char *name;
+		int what;
+		int lang;	// -1 work file, else the cxxmode it is read in.
+	} deps[] = {
+		{ "mainBP.c",	GEN_MAIN,	0 },
+		{ "noargsTXT.c",	GEN_MAIN,	-1 },
+		{ "getoptionsBP.h",	GEN_HDR,	0 },
+		{ "declTXT.h",	GEN_HDR | GEN_SRC,	-1 },
+		{ "getoptionsBP.c",	GEN_SRC,	0 },
+		{ "usageTXT.c",	GEN_SRC,	-1 },
+		{ "helpTXT.c",	GEN_SRC,	-1 },
+		{ "defltTXT.c",	GEN_SRC,	-1 },
+		{ "lostructTXT.c",	GEN_SRC,	-1 },
+		{ "locodeTXT.c",	GEN_SRC,	-1 },
+		{ "socodeTXT.c",	GEN_SRC,	-1 },
+		{ "constrTXT.c",	GEN_SRC,	-1 },
+		{ "lazyTXT.c",	GEN_SRC,	-1 },
+		{ "lazyTXT.h",	GEN_HDR,	-1 },
+		{ "MakefileBP",	GEN_MAKE,	0 },
+		{ "mainBP.cpp",	GEN_MAIN,	1 },
+		{ "getoptionsBP.hpp",	GEN_HDR,	1 },
+		{ "getoptionsBP.cpp",	GEN_SRC,	1 },
+		{ "MakefilecppBP",	GEN_MAKE,	1 },
+		{ NULL,	0,	0 }
+	};
+	int i;
+	for (i = 0; deps[i].name; i++) {
+		if (deps[i].lang != -1 && deps[i].lang != cxxmode) continue;
+		if (strcmp(filename, deps[i].name) == 0) return deps[i].what;
+	}
+	return 0;
+} // dependents()
+
+// how far selftestone() got, its exit status.
+static const char *selfteststage[] = {
+	"pass", "generate", "compile", "-h", "option run", "setup"
+};
+
+void selftest(char **specs, int nspecs, int jobs)
+{	/* Generates, compiles and runs the program for each dir of work
+	 * files in specs, at most jobs at a time, then reports the result
+	 * and time for each and exits. Each runs in a scratch dir which
+	 * is kept if the test fails.
+	*/
+	pid_t *pids = calloc(nspecs, sizeof(pid_t));
+	int *results = calloc(nspecs, sizeof(int));
+	double *secs = calloc(nspecs, sizeof(double));
+	char **scratch = calloc(nspecs, sizeof(char *));
+	struct timespec *t0 = calloc(nspecs, sizeof(struct timespec));
+	if (!pids || !results || !secs || !scratch || !t0) {
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
+	if (jobs < 1) jobs = 1;
+	char *tmpdir = getenv("TMPDIR");
+	if (!tmpdir) tmpdir = "/tmp";
+	int next = 0, running = 0, done = 0, failed = 0;
+	while (done < nspecs) {
+		while (running < jobs && next < nspecs) {
+			char buf[PATH_MAX];
+			sprintf(buf, "%s/gengoXXXXXX", tmpdir);
+			if (!mkdtemp(buf)) {
+				perror(buf);
+				exit(EXIT_FAILURE);
+			}
+			scratch[next] = strdup(buf);
+			fflush(stdout);
+			fflush(stderr);
+			clock_gettime(CLOCK_MONOTONIC, &t0[next]);
+			pids[next] = fork();
+			if (pids[next] == -1) {
+				perror("fork");
+				exit(EXIT_FAILURE);
+			}
+			if (pids[next] == 0)
+				exit(selftestone(specs[next], scratch[next]));
+			running++;
+			next++;
+		}
+		int status;
+		pid_t pid = wait(&status);
+		if (pid == -1) {
+			perror("wait");
+			exit(EXIT_FAILURE);
+		}
+		int i;
+		for (i = 0; i < next && pids[i] != pid; i++) ;
+		if (i == next) continue;	// not one of mine.
+		struct timespec t1;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		secs[i] = (t1.tv_sec - t0[i].tv_sec)
+					+ (t1.tv_nsec - t0[i].tv_nsec) / 1e9;
+		results[i] = (WIFEXITED(status) && WEXITSTATUS(status) <= 5)
+						? WEXITSTATUS(status) : 5;
+		running--;
+		done++;
+	}
+
+	int i;
+	for (i = 0; i < nspecs; i++) {
+		if (results[i]) {
+			failed++;
+			printf("FAIL %-30s %8.3fs %s, see %s/selftest.log\n",
+					specs[i], secs[i], selfteststage[results[i]],
+					scratch[i]);
+		} else {
+			char cmd[PATH_MAX];
+			sprintf(cmd, "%s/selftest.i", scratch[i]);
+			fdata idat = readfile(cmd, 0, 0);
+			unsigned long lines = 0;
+			char *cp;
+			for (cp = idat.from; cp && cp < idat.to; cp++)
+				if (*cp == '\n') lines++;
+			free(idat.from);
+			printf("PASS %-30s %8.3fs %7lu lines in getoptions.h\n",
+					specs[i], secs[i], lines);
+			sprintf(cmd, "rm -rf '%s'", scratch[i]);
+			dosystem(cmd);
+		}
+		free(scratch[i]);
+	}
+	printf("%d passed, %d failed\n", nspecs - failed, failed);
+	exit((failed) ? EXIT_FAILURE : EXIT_SUCCESS);
+} // selftest()
+
+int selftestone(const char *specdir, const char *scratch)
+{	/* Runs in a child of selftest(). Copies the work files in specdir
+	 * to scratch, generates the program there, compiles it, then runs
+	 * it with -h and once with each option. Returns the index in
+	 * selfteststage[] of the stage that failed, or 0.
+	*/
+	char fn[PATH_MAX];
+	int i;
+	for (i = 0; workfiles[i]; i++) {
+		sprintf(fn, "%s/%s", specdir, workfiles[i]);
+		if (fileexists(fn) == -1) continue;
+		fdata fdat = readfile(fn, 0, 1);
+		sprintf(fn, "%s/%s", scratch, workfiles[i]);
+		writefile(fn, fdat.from, fdat.to, "w");
+		free(fdat.from);
+	}
+	if (chdir(scratch) == -1) return 5;
+	int logfd = open("selftest.log", O_CREAT | O_WRONLY | O_TRUNC,
+						S_IRUSR | S_IWUSR);
+	if (logfd == -1) return 5;
+	dup2(logfd, 1);
+	dup2(logfd, 2);
+	close(logfd);
+	statsinit(STATS_NONE);
+	generatecode("selftest", 80, GEN_ALL);	// exits 1 on failure.
+
+	char *cc = getenv("CC");
+	char cmd[PATH_MAX];
+	sprintf(cmd, "%s -D_GNU_SOURCE=1 -o selftest selftest.c "
+			"getoptions.c", (cc) ? cc : "cc");
+	fflush(stdout);
+	if (system(cmd) != 0) return 2;
+	// what including getoptions.h costs, for the report.
+	sprintf(cmd, "%s -D_GNU_SOURCE=1 -E -P getoptions.h > selftest.i",
+			(cc) ? cc : "cc");
+	if (system(cmd) != 0) return 2;
+	if (system("./selftest -h") != 0) return 3;
+
+	/* Run each declared option, with a dummy argument for those that
+	 * want one and for each non-option argument. Only a crash or a
+	 * hang counts as failure, the program may reject the dummies. */
+	char posargs[NAME_MAX];
+	char **optargs = sampleargs(posargs, "selftest.c");
+	int failed = 0;
+	char **ap;
+	for (ap = optargs; *ap; ap++) {
+		if (!failed) {
+			snprintf(cmd, PATH_MAX, "timeout 10 ./selftest %s%s", *ap,
+						posargs);
+			fflush(stdout);
+			int status = system(cmd);
+			if (status == -1 || !WIFEXITED(status)
+				|| WEXITSTATUS(status) >= 124) {
+				fprintf(stderr, "%s: status %d\n", cmd, status);
+				failed = 4;
+			}
+		}
+		free(*ap);
+	}
+	free(optargs);
+	return failed;
+} // selftestone()
+
+char **sampleargs(char *posargs, const char *file)
+{	/* Each option of the work files in the current dir but -h as it is
+	 * given on a command line, "-c", "-c 1", "--name" or "--name 1",
+	 * with a dummy argument if it takes one; the long only options are
+	 * from lostructTXT.c. Returns them malloc()ed in a NULL terminated
+	 * array. posargs, NAME_MAX, gets a dummy for each non-option
+	 * argument, file for a file and "." for a dir, each after a space.
+	*/
+	char optstr[NAME_MAX] = "";
+	*posargs = '\0';
+	fdata fdat = readfile("defltTXT.c", 1, 0);
+	if (fdat.from) {
+		char *cp = strstr(fdat.from, "optstr[] = \"");
+		if (cp) sscanf(cp + strlen("optstr[] = \""), "%254[^\"]",
+						optstr);
+		free(fdat.from);
+	}
+	fdata lodat = readfile("lostructTXT.c", 1, 0);
+	size_t max = strlen(optstr) + 1;
+	char *cp;
+	if (lodat.from) {
+		*(lodat.to - 1) = '\0';
+		for (cp = lodat.from; (cp = strchr(cp, '{')); cp++) max++;
+	}
+	char **optargs = calloc(max, sizeof(char *));
+	if (!optargs) {
+		perror("sampleargs");
+		exit(EXIT_FAILURE);
+	}
+	int n = 0;
+	for (cp = optstr; *cp; cp++) {
+		if (*cp == ':' || *cp == 'h') continue;
+		char arg[8];
+		sprintf(arg, "-%c%s", *cp, (cp[1] == ':') ? " 1" : "");
+		optargs[n++] = strdup(arg);
+	}
+	if (lodat.from) {
+		char *line;
+		for (line = strtok(lodat.from, "\n"); line;
+				line = strtok(NULL, "\n")) {
+			char name[NAME_MAX], val[8];
+			int hasarg;
+			if (sscanf(line, " {\"%254[^\"]\", %d, %*d, %7[^ }]", name,
+						&hasarg, val) != 3 || strcmp(val, "0") != 0)
+				continue;	// not long only.
+			char arg[NAME_MAX + 8];
+			snprintf(arg, sizeof arg, "--%s%s", name,
+						(hasarg == 1) ? " 1" : "");
+			optargs[n++] = strdup(arg);
+		}
+		free(lodat.from);
+	}
+	fdat = readfile("noargsTXT.c", 1, 0);
+	if (fdat.from) {
+		char kinds[NAME_MAX] = "";
+		cp = strstr(fdat.from, "checkargs(");
+		if (cp) cp = strchr(cp, '"');
+		if (cp) sscanf(cp + 1, "%200[^\"]", kinds);
+		for (cp = kinds; *cp && strlen(posargs) + strlen(file) + 2
+							< NAME_MAX; cp++) {
+			strcat(posargs, " ");
+			strcat(posargs, (*cp == 'f' || *cp == 'F') ? file : ".");
+		}
+		free(fdat.from);
+	}
+	return optargs;
+} // sampleargs()
+
+void report(int pertext)
+{	/* Prints what the generated options cost: the size of options_t
+	 * and the padding in it, the bytes of the help text and option
+	 * tables in getoptions.o and the case blocks of the option
+	 * switches. With pertext also the .text of getoptions.o and what
+	 * each option's case block adds to it, found by compiling
+	 * getoptions.c without that block. The compiling is done in a
+	 * scratch dir under $TMPDIR with $CC, or $CXX with --cxx, which
+	 * is kept with its report.log if a compile fails.
+	*/
+	char *cc = getenv((cxxmode) ? "CXX" : "CC");
+	if (!cc) cc = (cxxmode) ? "c++" : "cc";
+	char *tmpdir = getenv("TMPDIR");
+	if (!tmpdir) tmpdir = "/tmp";
+	char scratch[PATH_MAX], cwd[PATH_MAX], fn[PATH_MAX];
+	char cmd[4 * PATH_MAX];
+	reportfmt(scratch, sizeof scratch, "%s/gengoXXXXXX", tmpdir);
+	if (!mkdtemp(scratch) || !getcwd(cwd, PATH_MAX)) {
+		perror(scratch);
+		exit(EXIT_FAILURE);
+	}
+	const char *hdrfile = (cxxmode) ? "getoptions.hpp" : "getoptions.h";
+	const char *ext = (cxxmode) ? "cpp" : "c";
+	char ccbase[3 * PATH_MAX];
+	reportfmt(ccbase, sizeof ccbase, "%s%s -D_GNU_SOURCE=1 -w -I'%s'",
+			cc, (cxxmode) ? " -std=c++17" : "", cwd);
+
+	// 1. options_t, compile a program to print its layout.
+	struct member {
+		char type[NAME_MAX], name[NAME_MAX];
+	} *mem = NULL;
+	int nmem = 0, i;
+	fdata dat = readfile("declTXT.h", 0, 0);
+	char *cp = dat.from;
+	while (cp && cp < dat.to) {
+		char *eol = memchr(cp, '\n', dat.to - cp);
+		if (!eol) eol = dat.to;
+		char line[NAME_MAX];
+		sprintf(line, "%.*s", (int)((eol - cp < NAME_MAX) ? eol - cp
+					: NAME_MAX - 1), cp);
+		cp = eol + 1;
+		mem = realloc(mem, (nmem + 1) * sizeof *mem);
+		if (!mem) {
+			perror("report");
+			exit(EXIT_FAILURE);
+		}
+		if (parsedecl(line, mem[nmem].type, mem[nmem].name) == 0) nmem++;
+	}
+	free(dat.from);
+	reportfmt(fn, sizeof fn, "%s/probe.%s", scratch, ext);
+	FILE *fp = dofopen(fn, "w");
+	fprintf(fp, "#include \"%s\"\n#include <stdio.h>\n"
+			"#include <stddef.h>\nint main(void)\n{\n"
+			"\tprintf(\"%%zu\\n\", sizeof(options_t));\n", hdrfile);
+	for (i = 0; i < nmem; i++)
+		fprintf(fp, "\tprintf(\"%%zu %%zu\\n\", offsetof(options_t, %s),"
+				" sizeof(((options_t *)0)->%s));\n", mem[i].name,
+				mem[i].name);
+	fputs("\treturn 0;\n}\n", fp);
+	fclose(fp);
+	reportfmt(cmd, sizeof cmd, "%s -o '%s/probe' '%s' >'%s/report.log' "
+			"2>&1 && '%s/probe'", ccbase, scratch, fn, scratch, scratch);
+	fflush(stdout);
+	FILE *pp = popen(cmd, "r");
+	size_t size = 0, off, len, end = 0, pad = 0;
+	if (!pp || fscanf(pp, "%zu", &size) != 1) {
+		fprintf(stderr, "report: can't compile %s, see %s/report.log\n",
+				fn, scratch);
+		exit(EXIT_FAILURE);
+	}
+	printf("options_t %zu bytes\n\t%6s %6s %6s  member\n", size,
+			"offset", "size", "pad");
+	for (i = 0; i < nmem && fscanf(pp, "%zu %zu", &off, &len) == 2;
+			i++) {
+		printf("\t%6zu %6zu %6zu  %s %s\n", off, len, off - end,
+				mem[i].type, mem[i].name);
+		pad += off - end;
+		end = off + len;
+	}
+	pad += size - end;
+	printf("\t%6zu %6s %6zu  (tail)\n\t%13s %6zu  padding in all\n", end,
+			"", size - end, "", pad);
+	pclose(pp);
+	free(mem);
+
+	// 2. the tables in getoptions.o.
+	fdata src;
+	if (amalgamate) {
+		static const char impl[] = "#define GETOPTIONS_IMPLEMENTATION\n";
+		fdata hdat = readfile(hdrfile, 0, 1);
+		src.from = malloc(strlen(impl) + (hdat.to - hdat.from));
+		if (!src.from) {
+			perror("report");
+			exit(EXIT_FAILURE);
+		}
+		strcpy(src.from, impl);
+		memcpy(src.from + strlen(impl), hdat.from, hdat.to - hdat.from);
+		src.to = src.from + strlen(impl) + (hdat.to - hdat.from);
+		free(hdat.from);
+	} else {
+		src = readfile((cxxmode) ? "getoptions.cpp" : "getoptions.c", 0, 1);
+	}
+	long text = reportcompile(ccbase, scratch, src.from, src.to);
+	if (text < 0) {
+		fprintf(stderr, "report: can't compile getoptions.%s, see "
+				"%s/report.log\n", ext, scratch);
+		exit(EXIT_FAILURE);
+	}
+	static const char *const tables[] = {
+		"helpmsg", "helpbrk", "helptab", "long_options", "optorig",
+		"envtab", "optrulemask", "optrulemsg", NULL
+	};
+	reportfmt(cmd, sizeof cmd, "nm -S -C '%s/opts.o'", scratch);
+	pp = popen(cmd, "r");
+	char line[PATH_MAX];
+	// helpmsg[] is text, helptab[]'s strings are in .rodata.str*.
+	unsigned long helpbytes = reporthelptext(src.from, src.to);
+	unsigned long tabbytes = 0;
+	printf("tables in getoptions.o\n");
+	while (pp && fgets(line, PATH_MAX, pp)) {
+		char sym[PATH_MAX], kind;
+		unsigned long addr, bytes;
+		if (sscanf(line, "%lx %lx %c %[^\n]", &addr, &bytes, &kind,
+					sym) != 4) continue;
+		for (i = 0; tables[i]; i++) {
+			// long_options is static in process_options(), decorated.
+			if ((i == 3) ? !strstr(sym, tables[i])
+				: strcmp(sym, tables[i]) != 0) continue;
+			printf("\t%6lu  %s%s\n", bytes, tables[i],
+					(i == 3) ? "[]" : "");
+			if (i == 0) helpbytes += bytes;
+			else if (i < 3) tabbytes += bytes;
+		}
+	}
+	if (pp) pclose(pp);
+	printf("\t%6lu  help text in all\n\t%6lu  help tables, helpbrk[] and "
+			"helptab[]\n", helpbytes, tabbytes);
+
+	// 3. the case blocks, and what each costs in .text.
+	fdata lostruct = readfile("lostructTXT.c", 0, 0);
+	static const char *const blkfiles[] = {
+		"socodeTXT.c", "locodeTXT.c"
+	};
+	static const char *const blkstarts[] = {
+		"\t\t\tcase '", "\t\t\t\t\tcase "
+	};
+	int nblk[2] = { 0, 0 }, f;
+	if (pertext) printf("getoptions.o .text %ld bytes, per case block what"
+				" it is over\n\tthat without the block, both at -O2,"
+				" < 0 where the block\n\tleft in lets the optimizer do"
+				" better\n", text);
+	for (f = 0; f < 2; f++) {
+		if (fileexists(blkfiles[f]) == -1) continue;
+		dat = readfile(blkfiles[f], 0, 1);
+		if (cxxmode) dat = cxxfilter(dat);
+		size_t slen = strlen(blkstarts[f]);
+		for (cp = dat.from; cp < dat.to; ) {
+			char *next = cp;
+			do {
+				next = memchr(next + 1, '\n', dat.to - next - 1);
+				next = (next) ? next + 1 : dat.to;
+			} while (next < dat.to && ((size_t)(dat.to - next) < slen
+					|| memcmp(next, blkstarts[f], slen) != 0));
+			if (memcmp(cp, blkstarts[f], slen) == 0) nblk[f]++;
+			else {
+				cp = next;
+				continue;
+			}
+			char *at = memmem(src.from, src.to - src.from, cp, next - cp);
+			if (pertext && at) {
+				char name[NAME_MAX + 2];
+				blockname(cp, lostruct, name);
+				fdata less;
+				less.from = malloc((src.to - src.from) - (next - cp));
+				if (!less.from) {
+					perror("report");
+					exit(EXIT_FAILURE);
+				}
+				memcpy(less.from, src.from, at - src.from);
+				memcpy(less.from + (at - src.from), at + (next - cp),
+						src.to - at - (next - cp));
+				less.to = less.from + (src.to - src.from) - (next - cp);
+				long lesstext = reportcompile(ccbase, scratch, less.from,
+												less.to);
+				free(less.from);
+				if (lesstext < 0) printf("\t%6s  %s\n", "?", name);
+				else printf("\t%6ld  %s\n", text - lesstext, name);
+			}
+			cp = next;
+		}
+		free(dat.from);
+	}
+	printf("case blocks %d, %d short, %d long only\n", nblk[0] + nblk[1],
+			nblk[0], nblk[1]);
+	free(lostruct.from);
+	free(src.from);
+	reportfmt(cmd, sizeof cmd, "rm -rf '%s'", scratch);
+	dosystem(cmd);
+} // report()
+
+size_t reporthelptext(const char *from, const char *to)
+{	/* The bytes of the strings helptab[] points to in the generated
+	 * source from..to, NULs included, up to the ; that ends it. */
+	static const char tab[] = "helptab[] = {";
+	const char *cp = (from) ? memmem(from, to - from, tab,
+						strlen(tab)) : NULL;
+	size_t bytes = 0;
+	int instr = 0, n;
+	for (; cp && cp < to && (instr || *cp != ';'); cp++) {
+		if (*cp == '"') {
+			instr = !instr;
+			if (!instr) bytes++;	// the NUL
+		} else if (instr) {
+			if (*cp == '\\' && cp + 1 < to) {
+				cp++;	// 1 byte for the escape and \xhh or \ooo
+				if (*cp == 'x')
+					while (cp + 1 < to && isxdigit((unsigned char)cp[1]))
+						cp++;
+				for (n = 1; n < 3 && *cp >= '0' && *cp <= '7'
+						&& cp + 1 < to && cp[1] >= '0' && cp[1] <= '7';
+						n++) cp++;
+			}
+			bytes++;
+		}
+	}
+	return bytes;
+} // reporthelptext()
+
+long reportcompile(const char *ccbase, const char *scratch,
+					const char *from, const char *to)
+{	/* Compiles from..to as getoptions.c to scratch/opts.o with -O2,
+	 * returns its .text bytes or -1 if it doesn't compile. */
+	char fn[PATH_MAX], cmd[4 * PATH_MAX];
+	reportfmt(fn, sizeof fn, "%s/opts.%s", scratch,
+				(cxxmode) ? "cpp" : "c");
+	writefile(fn, from, to, "w");
+	reportfmt(cmd, sizeof cmd, "%s -O2 -c -o '%s/opts.o' '%s' "
+			">>'%s/report.log' 2>&1 && size -A '%s/opts.o'", ccbase,
+			scratch, fn, scratch, scratch);
+	fflush(stdout);
+	FILE *pp = popen(cmd, "r");
+	char line[PATH_MAX];
+	long text = -1;
+	while (pp && fgets(line, PATH_MAX, pp)) {
+		if (strncmp(line, ".text ", 6) == 0)
+			text = strtol(line + 6, NULL, 10);
+	}
+	if (pp) pclose(pp);
+	return text;
+} // reportcompile()
+
+void reportfmt(char *buf, size_t size, const char *fmt, ...)
+{	/* The printf of fmt to buf of size bytes, a path or a command of
+	 * report(), which gives up if it doesn't fit. */
+	va_list ap;
+	va_start(ap, fmt);
+	int len = vsnprintf(buf, size, fmt, ap);
+	va_end(ap);
+	if (len < 0 || (size_t)len >= size) {
+		fprintf(stderr, "report: path too long in %s\n", fmt);
+		exit(EXIT_FAILURE);
+	}
+} // reportfmt()
+
+int lint(void)
+{	/* Checks the work files in the current dir for short option chars
+	 * given twice, long option names given twice, 2 options making 1
+	 * name in the environment, a long name whose char is not in the
+	 * optstring and options_t members declared twice, which are
+	 * errors, and long names that are a prefix of another, which
+	 * getopt_long() can't abbreviate and so are warned of. Names are checked in hash sets
+	 * and prefixes by a scan of the sorted names, so the time is near
+	 * linear in the options.
+	 * Returns the number of errors.
+	*/
+	int errors = 0, i, j;
+	// short option chars, in the optstring.
+	unsigned char shortseen[UCHAR_MAX + 1] = { 0 };
+	char optstr[NAME_MAX] = "";
+	fdata dat = readfile("defltTXT.c", 1, 0);
+	if (dat.from) {
+		*(dat.to - 1) = '\0';
+		char *cp = strstr(dat.from, "optstr[] = \"");
+		if (cp) sscanf(cp + strlen("optstr[] = \""), "%254[^\"]", optstr);
+		free(dat.from);
+	}
+	for (i = 0; optstr[i]; i++) {
+		unsigned char c = optstr[i];
+		if (c == ':') continue;
+		if (shortseen[c]++ == 1)
+			fprintf(stderr, "lint: -%c is in the optstring twice%s\n",
+					c, (c == 'h') ? ", -h is for help" : "");
+		if (shortseen[c] == 2) errors++;
+	}
+
+	// long option names, help first as in long_options[].
+	char **names = malloc(sizeof(char *));
+	int nnames = 0;
+	if (!names) {
+		perror("lint");
+		exit(EXIT_FAILURE);
+	}
+	names[nnames++] = strdup("help");
+	dat = readfile("lostructTXT.c", 0, 0);
+	char *cp = dat.from;
+	while (cp && cp < dat.to) {
+		char *eol = memchr(cp, '\n', dat.to - cp);
+		if (!eol) eol = dat.to;
+		char name[NAME_MAX];
+		if (sscanf(cp, " {\"%254[^\"]", name) == 1) {
+			char *q = memchr(cp, '\'', eol - cp);
+			if (q && q + 1 < eol && !shortseen[(unsigned char)q[1]]) {
+				fprintf(stderr, "lint: --%s is for -%c which is not in "
+						"the optstring\n", name, q[1]);
+				errors++;
+			}
+			names = realloc(names, (nnames + 1) * sizeof(char *));
+			if (!names) {
+				perror("lint");
+				exit(EXIT_FAILURE);
+			}
+			names[nnames++] = strdup(name);
+		}
+		cp = eol + 1;
+	}
+	free(dat.from);
+	errors += lintdups(names, nnames, "--%s is a long option twice");
+	// a name that begins another can only be given in full.
+	qsort(names, nnames, sizeof(char *), lintcmp);
+	for (i = 0; i < nnames; i++) {
+		size_t len = strlen(names[i]);
+		for (j = i + 1; j < nnames
+				&& strncmp(names[i], names[j], len) == 0; j++) {
+			if (names[j][len])
+				fprintf(stderr, "lint: warning: --%s is a prefix of "
+						"--%s, so can't be abbreviated\n", names[i],
+						names[j]);
+		}
+	}
+	/* PROG_LONGNAME or PROG_MEMBER for a short option in the
+	 * environment, which 2 names differing only in case or punctuation
+	 * would share. */
+	char shnames[ENVMAX][NAME_MAX], shchars[ENVMAX];
+	int shargs[ENVMAX];
+	int nshort = shortenv(shnames, shchars, shargs, ENVMAX);
+	char **envs = malloc((nnames + nshort) * sizeof(char *));
+	int nenvs = 0;
+	if (!envs) {
+		perror("lint");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < nnames + nshort; i++) {
+		if (i && i < nnames && strcmp(names[i], names[i - 1]) == 0)
+			continue;
+		envs[nenvs] = strdup((i < nnames) ? names[i]
+						: shnames[i - nnames]);
+		for (cp = envs[nenvs]; *cp; cp++) *cp = envchar(*cp);
+		nenvs++;
+	}
+	errors += lintdups(envs, nenvs, "2 options are PROG_%s in the "
+						"environment");
+	for (i = 0; i < nenvs; i++) free(envs[i]);
+	free(envs);
+	for (i = 0; i < nnames; i++) free(names[i]);
+	free(names);
+
+	// members of options_t.
+	names = NULL;
+	nnames = 0;
+	dat = readfile("declTXT.h", 0, 0);
+	cp = dat.from;
+	while (cp && cp < dat.to) {
+		char *eol = memchr(cp, '\n', dat.to - cp);
+		if (!eol) eol = dat.to;
+		char line[NAME_MAX], type[NAME_MAX], name[NAME_MAX];
+		sprintf(line, "%.*s", (int)((eol - cp < NAME_MAX) ? eol - cp
+					: NAME_MAX - 1), cp);
+		cp = eol + 1;
+		if (parsedecl(line, type, name) != 0) continue;
+		names = realloc(names, (nnames + 1) * sizeof(char *));
+		if (!names) {
+			perror("lint");
+			exit(EXIT_FAILURE);
+		}
+		names[nnames++] = strdup(name);
+	}
+	free(dat.from);
+	errors += lintdups(names, nnames,
+						"options_t member %s is declared twice");
+	for (i = 0; i < nnames; i++) free(names[i]);
+	free(names);
+	return errors;
+} // lint()
+
+int lintdups(char **names, int nnames, const char *fmt)
+{	/* Reports with fmt each of names that is there more than once, by
+	 * way of an open addressed hash set. Returns how many there are.
+	*/
+	size_t size = 16, i;
+	while (size < 2 * (size_t)nnames) size *= 2;
+	char **set = calloc(size, sizeof(char *));
+	if (!set) {
+		perror("lintdups");
+		exit(EXIT_FAILURE);
+	}
+	int dups = 0, n;
+	for (n = 0; n < nnames; n++) {
+		unsigned h = 2166136261u;	// FNV-1a
+		const char *cp;
+		for (cp = names[n]; *cp; cp++)
+			h = (h ^ (unsigned char)*cp) * 16777619u;
+		for (i = h & (size - 1); set[i]; i = (i + 1) & (size - 1)) {
+			if (strcmp(set[i], names[n]) == 0) break;
+		}
+		if (set[i]) {
+			fprintf(stderr, "lint: ");
+			fprintf(stderr, fmt, names[n]);
+			fputc('\n', stderr);
+			dups++;
+		} else {
+			set[i] = names[n];
+		}
+	}
+	free(set);
+	return dups;
+} // lintdups()
+
+int lintcmp(const void *a, const void *b)
+{	/* qsort() order of 2 char pointers. */
+	return strcmp(*(char *const *)a, *(char *const *)b);
+} // lintcmp()
+
 void fatal(const char *msg)
 {
 	fprintf(stderr, "%s\n", msg);
@@ -601,24 +2279,40 @@ fdata fmtusagelines(const char *progname, char *from, char *to)
 	return ret;	// caller is required to free ret.from
 } // fmtusagelines()
 
-fdata fmthelplines(char *from, char *to, int cols)
+fdata fmthelplines(char *from, char *to, FILE *fpcat)
 {	/*
-	 * formats each option and lines following like this:
-	 *  "\t-x[, --longx]
-	 *  "\tLorem ipsum dolor sit amet, consetetur \n"
-	 *  "\telitr, sed diam nonumyeirmod tempor invidunt\n"
-	 *  "\tut labore et dolore kimata sanctus est Lorem\n"
-	 *  "\tipsum dolor sit amet.Lorem ipsum dolor sit\n"
-	 *  "\tamet, consete\n"
+	 * formats each option and the help lines following it into the
+	 * generated helpbrk[] and helptab[] like this:
+	 *  static const unsigned short helpbrk[][2] = {
+	 *    {5, 5}, {11, 11}, ... {42, 42},
+	 *  };
+	 *  static const helppara helptab[] = {
+	 *    { "-x[, --longx]",
+	 *      "Lorem ipsum dolor sit amet, consetetur elitr",
+	 *      helpbrk + 0, 7 },
+	 *    ...
+	 * The help text is collapsed to 1 line and each pair in helpbrk[]
+	 * is the byte offset and display column of the end of a word.
+	 * dohelp() uses them to wrap the text to the width of the terminal
+	 * at run time without rescanning the text.
+	 * If fpcat, each option and its collapsed text are also written
+	 * to it as tab indented lines, for the catalog.
+	 * from may be NULL, for no user options.
 	*/
-	char resbuf[PATH_MAX];
-	size_t tabsize = 8;
+	char *tabbuf, *brkbuf;
+	size_t tablen, brklen;
+	FILE *fptab = open_memstream(&tabbuf, &tablen);
+	FILE *fpbrk = open_memstream(&brkbuf, &brklen);
+	if (!fptab || !fpbrk) {
+		perror("open_memstream");
+		exit(EXIT_FAILURE);
+	}
+	size_t totbrk = 0;	// entries in helpbrk[] so far.
 
 	// the scope of the search
-	resbuf[0] = '\0';	// will concatenate the options text here
 	fdata opthelp;
 	opthelp.from = from; 	// the starting point.
-	while (1) {
+	while (from) {
 		// the scope of each option and associated help lines.
 		opthelp.from = memmem(opthelp.from, to - opthelp.from,
 								"\n-", 2);	/* look for eol followed by
@@ -628,53 +2322,521 @@ fdata fmthelplines(char *from, char *to, int cols)
 		opthelp.to = memmem(opthelp.from, to - opthelp.from,
 							"\n-", 2);
 		if (!opthelp.to) opthelp.to = to;	// now at last option.
-		// make a copy of the user provided options mess.
-		char *optmess = malloc(opthelp.to - opthelp.from);
-		char *omend = optmess + (opthelp.to - opthelp.from);
-		memcpy(optmess, opthelp.from, opthelp.to - opthelp.from);
 		/* First up, I will split off the actual option identifiers,
-		 * "-x", "-x, --longx", or "--longx" alone. I will put this on
-		 * it's own line. It is already separated by '\n'.
+		 * "-x", "-x, --longx", or "--longx" alone. It is already
+		 * separated by '\n'.
 		*/
-		char *eol = memchr(optmess, '\n', omend - optmess);
-		*eol = '\0';
-		char linebuf[NAME_MAX];
-		char *fmt = "  \"\\t%s\\n\"\n";
-		sprintf(linebuf, fmt, optmess);
-		strcat(resbuf, linebuf);
-		char *cp = eol + 1;
-		// turn cp into a C string.
-		*(omend -1) = '\0';
-		// make the rest of the mess into 1 long line.
-		while (cp < omend) {
-			if (*cp == '\n') *cp = ' ';
-			cp++;
+		char *eol = memchr(opthelp.from, '\n',
+							opthelp.to - opthelp.from);
+		if (!eol) eol = opthelp.to;
+		fputs("  { \"", fptab);
+		cstrwrite(fptab, opthelp.from, eol);
+		if (fpcat) fprintf(fpcat, "\t%.*s\n\t",
+							(int)(eol - opthelp.from), opthelp.from);
+		fputs("\",\n    \"", fptab);
+		/* make the rest of the mess into 1 long line, words separated
+		 * by exactly 1 space, and note where each word ends. */
+		char *cp = eol;
+		size_t off = 0, col = 0, nbrk = 0;
+		fputs(" ", fpbrk);
+		while (cp < opthelp.to) {
+			while (cp < opthelp.to && isspace((unsigned char)*cp)) cp++;
+			if (cp == opthelp.to || *cp == '\0') break;
+			char *eow = cp;
+			while (eow < opthelp.to && *eow
+					&& !isspace((unsigned char)*eow)) eow++;
+			if (nbrk) {
+				fputc(' ', fptab);
+				off++;
+				col++;
+			}
+			cstrwrite(fptab, cp, eow);
+			if (fpcat) fprintf(fpcat, "%s%.*s", (nbrk) ? " " : "",
+								(int)(eow - cp), cp);
+			off += eow - cp;
+			col += u8width(cp, eow);
+			fprintf(fpbrk, " {%zu, %zu},", off, col);
+			nbrk++;
+			cp = eow;
+		}
+		fputs("\n", fpbrk);
+		if (fpcat) fputc('\n', fpcat);
+		if (off > USHRT_MAX) fatal("Help text for an option > 64k.");
+		fprintf(fptab, "\",\n    helpbrk + %zu, %zu },\n", totbrk,
+					nbrk);
+		totbrk += nbrk;
+		opthelp.from = opthelp.to;	// ready for next option if any.
+	}
+	fclose(fptab);
+	fclose(fpbrk);
+
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	fprintf(fpres, "static const unsigned short helpbrk[][2] = {\n%s"
+			"};\n\nstatic const helppara helptab[] = {\n%s"
+			"  { NULL, NULL, NULL, 0 }\n};\n\n",
+			(totbrk) ? brkbuf : "  {0, 0}\n", tabbuf);
+	fclose(fpres);
+	free(tabbuf);
+	free(brkbuf);
+	fdata retdat;
+	retdat.from = resbuf;
+	retdat.to = retdat.from + reslen;
+	return retdat;
+} // fmthelplines()
+
+fdata fmtenvtab(const char *progname, char *from, char *to)
+{	/*
+	 * writes envprefix[] and envtab[] for the long options named in
+	 * lostructTXT.c from..to and the short options without one, so
+	 * that eg PROG_OUTPUT=x in the environment acts like --output=x
+	 * ahead of the command line.
+	 *  #define ENVTABSIZE 8
+	 *  static const char envprefix[] = "PROG_";
+	 *  static const envbind envtab[ENVTABSIZE] = {
+	 *    { "OUTPUT", "--output", 1 },
+	 *    { NULL, NULL, 0 },
+	 *    { "VERBOSE", "-v", 0 },
+	 *    ...
+	 * The environment name is the long name, or for a short option the
+	 * options_t member it sets as shortenv() finds it, upper cased with
+	 * any other character as '_', lint() sees that no 2 options make
+	 * the same one. envtab[] is an open addressed hash table, slot envhash(name) or
+	 * the first free one after it, at most half full so that the
+	 * lookup in envoptions() always reaches a NULL slot.
+	 * from may be NULL, for no long options.
+	*/
+	char names[ENVMAX][NAME_MAX], chars[ENVMAX], slots[ENVMAX * 2];
+	int hasarg[ENVMAX];
+	size_t nnames = 0, size = 1;
+	char *cp = from;
+	while (cp && cp < to) {
+		char *eol = memchr(cp, '\n', to - cp);
+		if (!eol) eol = to;
+		char *q = memchr(cp, '"', eol - cp);
+		char *eq = (q) ? memchr(q + 1, '"', eol - q - 1) : NULL;
+		if (eq && eq - q - 1 < NAME_MAX) {
+			if (nnames == ENVMAX) fatal("Too many long options.");
+			memcpy(names[nnames], q + 1, eq - q - 1);
+			names[nnames][eq - q - 1] = '\0';
+			hasarg[nnames] = (int)strtol(eq + 2, NULL, 10);
+			chars[nnames] = '\0';
+			nnames++;
 		}
-		// now split this text into pieces that fit.
-		size_t wid = cols - tabsize;
 		cp = eol + 1;
-		while (strlen(cp) > wid) {
-			eol = cp + wid;
-			while (*eol != ' ') eol--;
-			*eol = '\0';
-			sprintf(linebuf, fmt, cp);
-			strcat(resbuf, linebuf);
-			cp = eol + 1;
+	}
+	nnames += shortenv(names + nnames, chars + nnames, hasarg + nnames,
+							ENVMAX - nnames);
+	while (size < 2 * nnames) size *= 2;
+	memset(slots, 0, sizeof slots);
+
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	if (!fpres) {
+		perror("open_memstream");
+		exit(EXIT_FAILURE);
+	}
+	fprintf(fpres, "\n#define ENVTABSIZE %zu\nstatic const char "
+				"envprefix[] = \"", size);
+	const char *pp;
+	for (pp = progname; *pp; pp++)
+		fputc(isalnum((unsigned char)*pp)
+				? toupper((unsigned char)*pp) : '_', fpres);
+	fputs("_\";\n", fpres);
+	// place each name, then write the slots in order.
+	int where[ENVMAX * 2];
+	size_t i;
+	for (i = 0; i < nnames; i++) {
+		char *np;
+		unsigned h = 2166136261u;	// FNV-1a as envhash()
+		for (np = names[i]; *np; np++)
+			h = (h ^ (unsigned char)envchar(*np)) * 16777619u;
+		h &= size - 1;
+		while (slots[h]) h = (h + 1) & (size - 1);
+		slots[h] = 1;
+		where[h] = i;
+	}
+	fputs("static const envbind envtab[ENVTABSIZE] = {\n", fpres);
+	for (i = 0; i < size; i++) {
+		if (!slots[i]) {
+			fputs("  { NULL, NULL, 0 },\n", fpres);
+			continue;
+		}
+		int k = where[i];
+		char *np;
+		fputs("  { \"", fpres);
+		for (np = names[k]; *np; np++) fputc(envchar(*np), fpres);
+		if (chars[k])
+			fprintf(fpres, "\", \"-%c\", %d },\n", chars[k], hasarg[k]);
+		else
+			fprintf(fpres, "\", \"--%s\", %d },\n", names[k], hasarg[k]);
+	}
+	fputs("};\n", fpres);
+	fclose(fpres);
+	fdata retdat;
+	retdat.from = resbuf;
+	retdat.to = retdat.from + reslen;
+	return retdat;
+} // fmtenvtab()
+
+int envchar(int c)
+{	/* c as it is in the environment name of a long option. */
+	return (isalnum((unsigned char)c)) ? toupper((unsigned char)c) : '_';
+} // envchar()
+
+int shortenv(char names[][NAME_MAX], char *chars, int *hasarg, int max)
+{	/* Finds the short options of the optstring in defltTXT.c that no
+	 * long option in lostructTXT.c is for and, from socodeTXT.c, the
+	 * options_t member each one sets, opts.<name> or for a lazy option
+	 * opts.<name>_arg, which names it in the environment. Fills at
+	 * most max of names, chars and hasarg, 2 for an optional argument,
+	 * and returns how many. A short option whose code sets no member
+	 * has no environment name.
+	*/
+	char optstr[NAME_MAX] = "";
+	unsigned char haslong[UCHAR_MAX + 1] = { 0 };
+	fdata dat = readfile("defltTXT.c", 1, 0);
+	if (dat.from) {
+		*(dat.to - 1) = '\0';
+		char *cp = strstr(dat.from, "optstr[] = \"");
+		if (cp) sscanf(cp + strlen("optstr[] = \""), "%254[^\"]", optstr);
+		free(dat.from);
+	}
+	haslong['h'] = 1;	// --help
+	dat = readfile("lostructTXT.c", 0, 0);
+	char *cp = dat.from;
+	while (cp && cp < dat.to) {
+		char *eol = memchr(cp, '\n', dat.to - cp);
+		if (!eol) eol = dat.to;
+		char *q = memchr(cp, '\'', eol - cp);
+		if (q && q + 1 < eol) haslong[(unsigned char)q[1]] = 1;
+		cp = eol + 1;
+	}
+	free(dat.from);
+
+	int n = 0;
+	unsigned char cur = 0;
+	dat = readfile("socodeTXT.c", 0, 0);
+	cp = dat.from;
+	while (cp && cp < dat.to) {
+		char *eol = memchr(cp, '\n', dat.to - cp);
+		if (!eol) eol = dat.to;
+		char *mp;
+		char c;
+		if (sscanf(cp, " case '%c':", &c) == 1) {
+			cur = (unsigned char)c;
+			char *op = strchr(optstr, c);
+			if (haslong[cur] || !op || c == ':') cur = 0;
+		} else if (cur && (mp = memmem(cp, eol - cp, "opts.", 5))) {
+			mp += 5;
+			size_t len = 0;
+			while (mp + len < eol && (isalnum((unsigned char)mp[len])
+						|| mp[len] == '_')) len++;
+			if (len > 4 && eol - (mp + len - 4) >= 14
+					&& memcmp(mp + len - 4, "_arg = optarg;", 14) == 0)
+				len -= 4;
+			if (len && len < NAME_MAX && n < max) {
+				memcpy(names[n], mp, len);
+				names[n][len] = '\0';
+				chars[n] = cur;
+				char *op = strchr(optstr, cur);
+				hasarg[n] = (op[1] != ':') ? 0 : (op[2] == ':') ? 2 : 1;
+				n++;
+			}
+			cur = 0;	// the first member set names it.
 		}
-		if (strlen(cp)) {
-			sprintf(linebuf, fmt, cp);
-			strcat(resbuf, linebuf);
+		cp = eol + 1;
+	}
+	free(dat.from);
+	return n;
+} // shortenv()
+
+fdata fmtserial(char *from, char *to)
+{	/*
+	 * writes options_serialize(), options_deserialize(),
+	 * options_convert() and options_dispose() for the members of
+	 * options_t declared in declTXT.h from..to, 1 line of the function
+	 * body each in declaration order:
+	 *  off = optput(buf, size, off, &opts->count, sizeof opts->count);
+	 *  off = optputstr(buf, size, off, opts->output);
+	 *  off = optputlist(buf, size, off, &opts->incs);
+	 * Declarations that are not "type name;" and pointers other than
+	 * strings are left out with a comment, as is the <var>_done after
+	 * the <var>_arg of a lazy option, so that the process that gets
+	 * the options converts <var> from <var>_arg itself, which
+	 * options_convert() does for each with opt_<var>(). OPTIONS_LAYOUT
+	 * is a hash of the declarations so that a buffer from another
+	 * build of options_t is refused. All but options_dispose(), which
+	 * the bulk parse uses too, are compiled in only with GENGO_SERIAL.
+	 * from may be NULL, for no user options.
+	*/
+	char *putbuf, *getbuf, *freebuf, *convbuf;
+	size_t putlen, getlen, freelen, convlen;
+	FILE *fpput = open_memstream(&putbuf, &putlen);
+	FILE *fpget = open_memstream(&getbuf, &getlen);
+	FILE *fpfree = open_memstream(&freebuf, &freelen);
+	FILE *fpconv = open_memstream(&convbuf, &convlen);
+	if (!fpput || !fpget || !fpfree || !fpconv) {
+		perror("open_memstream");
+		exit(EXIT_FAILURE);
+	}
+	unsigned layout = 2166136261u;	// FNV-1a
+	layout = (layout ^ (unsigned)cxxmode) * 16777619u;
+	char lazyvar[NAME_MAX] = "";	// <var> of the last <var>_arg
+	char *cp = from;
+	while (cp && cp < to) {
+		char *eol = memchr(cp, '\n', to - cp);
+		if (!eol) eol = to;
+		char line[NAME_MAX];
+		size_t len = eol - cp;
+		if (len >= NAME_MAX) len = NAME_MAX - 1;
+		memcpy(line, cp, len);
+		line[len] = '\0';
+		cp = eol + 1;
+		size_t i;
+		for (i = 0; i < len; i++)
+			layout = (layout ^ (unsigned char)line[i]) * 16777619u;
+		char name[NAME_MAX], type[NAME_MAX];
+		int res = parsedecl(line, type, name);
+		if (res == -1) fprintf(fpput, "\t// not serialized: %s\n", line);
+		if (res) continue;
+		size_t nlen = strlen(name);
+		if (*lazyvar && strcmp(type, "int") == 0 && nlen > 5
+			&& strcmp(name + nlen - 5, "_done") == 0
+			&& strncmp(name, lazyvar, nlen - 5) == 0
+			&& lazyvar[nlen - 5] == '\0') {
+			fprintf(fpput, "\t// not serialized: %s\n", line);
+			fprintf(fpconv, "\t(void)opt_%s(opts);\n", lazyvar);
+			continue;
+		}
+		*lazyvar = '\0';
+		if (strcmp(type, "char*") == 0) {
+			if (nlen > 4 && strcmp(name + nlen - 4, "_arg") == 0)
+				sprintf(lazyvar, "%.*s", (int)(nlen - 4), name);
+			fprintf(fpput, "\toff = optputstr(buf, size, off, "
+						"opts->%s);\n", name);
+			fprintf(fpget, "\toff = optgetstr(buf, len, off, "
+						"&o.%s);\n", name);
+		} else if (strcmp(type, "optlist") == 0) {
+			fprintf(fpput, "\toff = optputlist(buf, size, off, "
+						"&opts->%s);\n", name);
+			fprintf(fpget, "\toff = optgetlist(buf, len, off, "
+						"&o.%s);\n", name);
+			fprintf(fpfree, "\toptfreelist(&opts->%s);\n", name);
+		} else if (strchr(type, '*')) {
+			fprintf(fpput, "\t// not serialized: %s\n", line);
+		} else {
+			fprintf(fpput, "\toff = optput(buf, size, off, &opts->%s,"
+						"\n\t\t\t\tsizeof opts->%s);\n", name, name);
+			fprintf(fpget, "\toff = optget(buf, len, off, &o.%s,"
+						" sizeof o.%s);\n", name, name);
 		}
-		free(optmess);
-		opthelp.from = opthelp.to;	// ready for next option if any.
 	}
+	fclose(fpput);
+	fclose(fpget);
+	fclose(fpfree);
+	fclose(fpconv);
+
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	fprintf(fpres,
+		"\n#ifdef GENGO_SERIAL\n#define OPTIONS_LAYOUT 0x%08xu\n\n"
+		"size_t options_serialize(const options_t *opts, char *buf,"
+		" size_t size)\n"
+		"{\t/* Writes opts to buf if it fits in size bytes. Returns the"
+		" size\n\t * needed, so a size of 0 finds how big buf must"
+		" be. */\n"
+		"\tsize_t off = OPTS_HEADER;\n%s"
+		"\toptsheader(buf, size, OPTIONS_LAYOUT, off);\n"
+		"\treturn off;\n"
+		"} // options_serialize()\n\n"
+		"int options_deserialize(options_t *opts, char *buf,"
+		" size_t len)\n"
+		"{\t/* Restores *opts from the len bytes at buf, strings point"
+		" into buf.\n\t * Returns -1, leaving *opts alone, if buf is"
+		" not from\n\t * options_serialize() of this options_t. */\n"
+		"\toptions_t o = %s;\n"
+		"\tsize_t off = optscheck(buf, len, OPTIONS_LAYOUT);\n%s"
+		"\tif (off != len) return -1;\n"
+		"\t*opts = o;\n"
+		"\treturn 0;\n"
+		"} // options_deserialize()\n\n"
+		"void options_convert(options_t *opts)\n"
+		"{\t/* Converts every lazy option of opts, so that it can be"
+		" read\n\t * through a const options_t *. */\n"
+		"\t(void)opts;\n%s"
+		"} // options_convert()\n#endif\n\n"
+		"void options_dispose(options_t *opts)\n"
+		"{\t/* Frees the lists in opts, not the strings in them. */\n"
+		"\t(void)opts;\n%s"
+		"} // options_dispose()\n",
+		layout, putbuf, (cxxmode) ? "{}" : "{ 0 }", getbuf, convbuf,
+		freebuf);
+	fclose(fpres);
+	free(putbuf);
+	free(getbuf);
+	free(freebuf);
+	free(convbuf);
 	fdata retdat;
-	size_t len = strlen(resbuf);
-	retdat.from = malloc(len);
-	memcpy(retdat.from, resbuf, len);
-	retdat.to = retdat.from + len;
+	retdat.from = resbuf;
+	retdat.to = retdat.from + reslen;
 	return retdat;
-} // fmthelplines()
+} // fmtserial()
+
+int parsedecl(const char *line, char *type, char *name)
+{	/* Splits a line of declTXT.h of the form "type name;", arrays
+	 * allowed, 1 declarator only. type loses its spaces, "char*",
+	 * "optlist", ... Returns 0 for such a line, -1 for any other
+	 * declaration and 1 for a line that declares nothing.
+	*/
+	const char *semi = strchr(line, ';');
+	if (!semi) return 1;
+	if (strstr(line, "/*") || strchr(line, ',')) return -1;
+	const char *ep = semi;
+	while (ep > line && (isspace((unsigned char)ep[-1])
+			|| ep[-1] == ']')) {
+		if (ep[-1] == ']') {
+			while (ep > line && ep[-1] != '[') ep--;
+		}
+		ep--;
+	}
+	const char *np = ep;
+	while (np > line && (isalnum((unsigned char)np[-1])
+			|| np[-1] == '_')) np--;
+	sprintf(name, "%.*s", (int)(ep - np), np);
+	char *tp = type;
+	const char *lp;
+	for (lp = line; lp < np; lp++)
+		if (!isspace((unsigned char)*lp)) *tp++ = *lp;
+	*tp = '\0';
+	return (!*name || !*type) ? 1 : 0;
+} // parsedecl()
+
+fdata fmttypeincludes(char *from, char *to)
+{	/* The #includes for the types and array sizes named in the
+	 * declTXT.h at from..to, so that getoptions.h need not include
+	 * every header getoptions.c does. A type not known here wants its
+	 * header added by hand.
+	*/
+	static const struct {
+		const char *type, *chdr, *cxxhdr;
+	} typehdr[] = {
+		{"FILE", "stdio.h", "cstdio"},
+		{"va_list", "stdarg.h", "cstdarg"},
+		{"bool", "stdbool.h", NULL},
+		{"time_t", "time.h", "ctime"},
+		{"regex_t", "regex.h", "regex.h"},
+		{"ssize_t", "sys/types.h", "sys/types.h"},
+		{"off_t", "sys/types.h", "sys/types.h"},
+		{"pid_t", "sys/types.h", "sys/types.h"},
+		{"mode_t", "sys/types.h", "sys/types.h"},
+		{"uid_t", "sys/types.h", "sys/types.h"},
+		{"gid_t", "sys/types.h", "sys/types.h"},
+		{"int8_t", "stdint.h", "cstdint"},
+		{"int16_t", "stdint.h", "cstdint"},
+		{"int32_t", "stdint.h", "cstdint"},
+		{"int64_t", "stdint.h", "cstdint"},
+		{"uint8_t", "stdint.h", "cstdint"},
+		{"uint16_t", "stdint.h", "cstdint"},
+		{"uint32_t", "stdint.h", "cstdint"},
+		{"uint64_t", "stdint.h", "cstdint"},
+		{"intmax_t", "stdint.h", "cstdint"},
+		{"uintmax_t", "stdint.h", "cstdint"},
+		{"intptr_t", "stdint.h", "cstdint"},
+		{"uintptr_t", "stdint.h", "cstdint"},
+		{"CHAR_BIT", "limits.h", "climits"},
+		{"INT_MAX", "limits.h", "climits"},
+		{"LONG_MAX", "limits.h", "climits"},
+		{"PATH_MAX", "linux/limits.h", "linux/limits.h"},
+		{"NAME_MAX", "linux/limits.h", "linux/limits.h"},
+		{NULL, NULL, NULL}
+	};
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	const char *done[sizeof typehdr / sizeof typehdr[0]];
+	int ndone = 0, i;
+	char *cp = from;
+	while (cp && cp < to) {
+		if (!isalpha((unsigned char)*cp) && *cp != '_') {
+			cp++;
+			continue;
+		}
+		char *word = cp;
+		while (cp < to && (isalnum((unsigned char)*cp) || *cp == '_'))
+			cp++;
+		size_t len = cp - word;
+		const char *hdr = NULL;
+		for (i = 0; !hdr && typehdr[i].type; i++) {
+			if (strlen(typehdr[i].type) == len
+				&& memcmp(typehdr[i].type, word, len) == 0)
+				hdr = (cxxmode) ? typehdr[i].cxxhdr : typehdr[i].chdr;
+		}
+		if (!hdr) continue;
+		for (i = 0; i < ndone && strcmp(done[i], hdr) != 0; i++) ;
+		if (i < ndone) continue;
+		done[ndone++] = hdr;
+		fprintf(fpres, "#include <%s>\n", hdr);
+	}
+	fclose(fpres);
+	fdata retdat;
+	retdat.from = resbuf;
+	retdat.to = resbuf + reslen;
+	return retdat;
+} // fmttypeincludes()
+
+void cstrwrite(FILE *fpo, const char *from, const char *to)
+{	/* writes from..to as the content of a C string literal. */
+	while (from < to) {
+		if (*from == '"' || *from == '\\') fputc('\\', fpo);
+		fputc(*from, fpo);
+		from++;
+	}
+} // cstrwrite()
+
+void cstrread(FILE *fpo, const char *from, const char *to)
+{	/* writes the text of the C string literals in from..to, the
+	 * reverse of cstrwrite(), knowing only the escapes gengo writes.
+	*/
+	int instr = 0;
+	while (from < to) {
+		if (*from == '"') {
+			instr = !instr;
+		} else if (instr && *from == '\\' && from + 1 < to) {
+			from++;
+			fputc((*from == 'n') ? '\n' : (*from == 't') ? '\t' : *from,
+					fpo);
+		} else if (instr) {
+			fputc(*from, fpo);
+		}
+		from++;
+	}
+} // cstrread()
+
+size_t u8width(const char *from, const char *to)
+{	/* Display width of the UTF-8 text from..to. Invalid bytes are
+	 * counted as 1 column each. */
+	mbstate_t mbs;
+	memset(&mbs, 0, sizeof mbs);
+	size_t width = 0;
+	while (from < to) {
+		wchar_t wc;
+		size_t n = mbrtowc(&wc, from, to - from, &mbs);
+		if (n == (size_t)-1 || n == (size_t)-2 || n == 0) {
+			memset(&mbs, 0, sizeof mbs);
+			width++;
+			from++;
+			continue;
+		}
+		int w = wcwidth(wc);
+		width += (w < 0) ? 1 : w;
+		from += n;
+	}
+	return width;
+} // u8width()
 
 fdata bracketsearch(char *from, char *to,  char *opn, char *cls)
 {
@@ -732,11 +2894,15 @@ void boilerplateinit(const char *bpfilename,
 {
 	/* Reads the bpfilename, finds the data between tags named by
 	 * tagname and writes such data to targetfilename. */
+	statsbegin("load %s", basename((char *)bpfilename));
 	bpfdat = readfile(bpfilename, 0, 1);
+	statsend();
+	statsbegin("%s <%s>", targetfilename, tagname);
 	tagpair tp = maketags(tagname);
 	fdata part = bracketsearch(bpfdat.from, bpfdat.to, tp.opntag,
 								tp.clstag);
 	writefile(targetfilename, part.from, part.to, "w");
+	statsend();
 } // boilerplateinit()
 
 void boilerplateappend(const char *targetfilename, char *tagname)
@@ -744,12 +2910,22 @@ void boilerplateappend(const char *targetfilename, char *tagname)
 	/* finds the data between tags named by tagname in the already
 	 * opened bp file and appends it to targetfilename
 	*/
+	statsbegin("%s <%s>", targetfilename, tagname);
 	tagpair tp = maketags(tagname);
 	fdata part = bracketsearch(bpfdat.from, bpfdat.to, tp.opntag,
 								tp.clstag);
 	writefile(targetfilename, part.from, part.to, "a");
+	statsend();
 } // boilerplateappend()
 
+fdata boilerplatesection(char *tagname)
+{
+	/* the data between tags named by tagname in the already opened bp
+	 * file, not a copy. */
+	tagpair tp = maketags(tagname);
+	return bracketsearch(bpfdat.from, bpfdat.to, tp.opntag, tp.clstag);
+} // boilerplatesection()
+
 void boilerplatedeinit(void)
 {
 	/* frees storage allocated by boilerplateinit() */
@@ -763,8 +2939,367 @@ void appenduserfile(const char *userfilename,
 	 * targetfilename, if userfilename exists that is.
 	*/
 	if (fileexists(userfilename) == 0) {
+		statsbegin("%s += %s", targetfilename, userfilename);
 		fdata ufdata = readfile(userfilename, 0, 1);
+		if (cxxmode) ufdata = cxxfilter(ufdata);
 		writefile(targetfilename, ufdata.from, ufdata.to, "a");
 		free(ufdata.from);
+		statsend();
 	}
 } // appenduserfile()
+
+void amalgamatefiles(const char *hdrfile, const char *srcfile)
+{	/* Appends srcfile to hdrfile, less its include of hdrfile, inside
+	 * #ifdef GETOPTIONS_IMPLEMENTATION, then removes srcfile. The one
+	 * file that defines GETOPTIONS_IMPLEMENTATION compiles the parser,
+	 * any other including hdrfile sees the declarations only.
+	*/
+	statsbegin("%s += %s, amalgamated", hdrfile, srcfile);
+	char inc[NAME_MAX];
+	sprintf(inc, "#include \"%s\"\n", hdrfile);
+	fdata sdat = memreplace(readfile(srcfile, 0, 1), inc, "");
+	static const char opn[] =
+	"\n#ifdef GETOPTIONS_IMPLEMENTATION\n"
+	"#ifndef GETOPTIONS_IMPLEMENTED\n"
+	"#define GETOPTIONS_IMPLEMENTED\n";
+	static const char cls[] =
+	"#endif // GETOPTIONS_IMPLEMENTED\n"
+	"#endif // GETOPTIONS_IMPLEMENTATION\n";
+	writefile(hdrfile, (char *)opn, (char *)opn + strlen(opn), "a");
+	writefile(hdrfile, sdat.from, sdat.to, "a");
+	writefile(hdrfile, (char *)cls, (char *)cls + strlen(cls), "a");
+	free(sdat.from);
+	if (unlink(srcfile) == -1) {
+		perror(srcfile);
+		exit(EXIT_FAILURE);
+	}
+	statsend();
+} // amalgamatefiles()
+
+void loadprofile(const char *path)
+{	/* Sums the "name count" lines of path, as appended to by programs
+	 * built with -DGENGO_PROFILE, into profile[]. */
+	fdata dat = readfile(path, 1, 1);
+	*(dat.to - 1) = '\0';
+	char *line, *save;
+	for (line = strtok_r(dat.from, "\n", &save); line;
+			line = strtok_r(NULL, "\n", &save)) {
+		char name[NAME_MAX];
+		unsigned long n;
+		if (sscanf(line, "%254s %lu", name, &n) != 2) continue;
+		int i;
+		for (i = 0; i < nprofile; i++) {
+			if (strcmp(profile[i].name, name) == 0) break;
+		}
+		if (i == nprofile) {
+			profile = realloc(profile, (nprofile + 1) * sizeof *profile);
+			if (!profile) {
+				perror("loadprofile");
+				exit(EXIT_FAILURE);
+			}
+			strcpy(profile[i].name, name);
+			profile[i].n = 0;
+			nprofile++;
+		}
+		profile[i].n += n;
+	}
+	free(dat.from);
+} // loadprofile()
+
+void lostructname(fdata lostruct, int n, int c, char *name)
+{	/* name becomes "--longname" from line n of lostructTXT.c, or from
+	 * the line for option char c when n is 0, else "". */
+	char *cp = lostruct.from;
+	int k = 1;
+	name[0] = '\0';
+	while (cp && cp < lostruct.to) {
+		char *eol = memchr(cp, '\n', lostruct.to - cp);
+		if (!eol) eol = lostruct.to;
+		char tail[8];
+		sprintf(tail, "'%c'}", c);
+		if ((n && k == n)
+			|| (!n && memmem(cp, eol - cp, tail, strlen(tail)))) {
+			char *q = memchr(cp, '"', eol - cp);
+			char *eq = (q) ? memchr(q + 1, '"', eol - q - 1) : NULL;
+			if (eq) sprintf(name, "--%.*s", (int)(eq - q - 1), q + 1);
+			return;
+		}
+		cp = eol + 1;
+		k++;
+	}
+} // lostructname()
+
+void blockname(const char *blk, fdata lostruct, char *name)
+{	/* name becomes the option that blk is for, "--longname" or "-c".
+	 * blk is a line of lostructTXT.c or a case of socodeTXT.c or
+	 * locodeTXT.c. */
+	char c;
+	int n = 0;
+	name[0] = '\0';
+	if (sscanf(blk, " {\"%252[^\"]", name + 2) == 1) {
+		name[0] = name[1] = '-';
+	} else if (sscanf(blk, " case '%c':", &c) == 1) {
+		lostructname(lostruct, 0, c, name);
+		if (!name[0]) sprintf(name, "-%c", c);
+	} else if (sscanf(blk, " case %d:", &n) == 1) {
+		lostructname(lostruct, n, 0, name);
+	}
+} // blockname()
+
+unsigned long profweight(const char *blk, fdata lostruct)
+{	/* The use count of the option that blk is for. */
+	char name[NAME_MAX + 2];
+	int i;
+	blockname(blk, lostruct, name);
+	for (i = 0; i < nprofile; i++) {
+		if (strcmp(profile[i].name, name) == 0) return profile[i].n;
+	}
+	return 0;
+} // profweight()
+
+fdata hotfirst(fdata in, const char *start, fdata lostruct, int *order)
+{	/* Returns a copy of in with its blocks, each from a line that
+	 * begins with start to the next, most used first and otherwise in
+	 * the order they were. Anything ahead of the first block stays
+	 * ahead. order[i], if wanted, becomes the place in in, counting
+	 * from 1, of the i'th block returned. Frees in.
+	*/
+	size_t slen = strlen(start);
+	int nblk = 0, i, j;
+	char *cp;
+	for (cp = in.from; cp && cp < in.to; cp++) {
+		if ((cp == in.from || cp[-1] == '\n')
+			&& (size_t)(in.to - cp) >= slen
+			&& memcmp(cp, start, slen) == 0) nblk++;
+	}
+	char **blk = malloc((nblk + 1) * sizeof(char *));
+	unsigned long *weight = malloc((nblk + 1) * sizeof(unsigned long));
+	int *idx = malloc((nblk + 1) * sizeof(int));
+	if (!blk || !weight || !idx) {
+		perror("hotfirst");
+		exit(EXIT_FAILURE);
+	}
+	nblk = 0;
+	for (cp = in.from; cp && cp < in.to; cp++) {
+		if ((cp == in.from || cp[-1] == '\n')
+			&& (size_t)(in.to - cp) >= slen
+			&& memcmp(cp, start, slen) == 0) {
+			blk[nblk] = cp;
+			weight[nblk] = profweight(cp, lostruct);
+			idx[nblk] = nblk;
+			nblk++;
+		}
+	}
+	blk[nblk] = in.to;
+	for (i = 1; i < nblk; i++) {	// stable, there are few of them.
+		int t = idx[i];
+		for (j = i; j > 0 && weight[idx[j - 1]] < weight[t]; j--)
+			idx[j] = idx[j - 1];
+		idx[j] = t;
+	}
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	if (nblk) fwrite(in.from, 1, blk[0] - in.from, fpres);
+	else if (in.from) fwrite(in.from, 1, in.to - in.from, fpres);
+	for (i = 0; i < nblk; i++) {
+		fwrite(blk[idx[i]], 1, blk[idx[i] + 1] - blk[idx[i]], fpres);
+		if (order) order[i] = idx[i] + 1;
+	}
+	fclose(fpres);
+	free(blk);
+	free(weight);
+	free(idx);
+	free(in.from);
+	fdata retdat;
+	retdat.from = resbuf;
+	retdat.to = resbuf + reslen;
+	return retdat;
+} // hotfirst()
+
+void appendhot(const char *userfilename, const char *targetfilename,
+				const char *start, fdata lostruct)
+{	/* appenduserfile() with the blocks of userfilename that begin with
+	 * start in profile order when there is a --profile. */
+	if (!nprofile) {
+		appenduserfile(userfilename, targetfilename);
+		return;
+	}
+	if (fileexists(userfilename) == -1) return;
+	statsbegin("%s += %s, hottest first", targetfilename, userfilename);
+	fdata ufdata = hotfirst(readfile(userfilename, 0, 1), start,
+							lostruct, NULL);
+	if (cxxmode) ufdata = cxxfilter(ufdata);
+	writefile(targetfilename, ufdata.from, ufdata.to, "a");
+	free(ufdata.from);
+	statsend();
+} // appendhot()
+
+fdata fmtoptorder(fdata lostruct)
+{	/* OPTORIG(), the index getopt_long() returns in the original
+	 * long_options[] order of the lostructTXT.c at from..to, from the
+	 * index in profile order. */
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	int n = 0, i;
+	char *cp;
+	for (cp = lostruct.from; cp && cp < lostruct.to; cp++)
+		if (*cp == '\n') n++;
+	if (!nprofile || !n) {
+		fputs("\n#define OPTORIG(i)\t(i)\n", fpres);
+	} else {
+		int *order = malloc(n * sizeof(int));
+		fdata copy;
+		copy.from = malloc(lostruct.to - lostruct.from);
+		if (!order || !copy.from) {
+			perror("fmtoptorder");
+			exit(EXIT_FAILURE);
+		}
+		memcpy(copy.from, lostruct.from, lostruct.to - lostruct.from);
+		copy.to = copy.from + (lostruct.to - lostruct.from);
+		fdata sorted = hotfirst(copy, "\t\t\t{", lostruct, order);
+		free(sorted.from);
+		fputs("\n// long_options[] is in profile order, help stays 1st.\n"
+				"static const unsigned short optorig[] = { 0,", fpres);
+		for (i = 0; i < n; i++) fprintf(fpres, " %d,", order[i]);
+		fputs(" 0 };\n#define OPTORIG(i)\toptorig[i]\n", fpres);
+		free(order);
+	}
+	fclose(fpres);
+	fdata retdat;
+	retdat.from = resbuf;
+	retdat.to = resbuf + reslen;
+	return retdat;
+} // fmtoptorder()
+
+fdata cxxfilter(fdata ufdata)
+{
+	/* Turns the C in a work file into the C++ the C++ boilerplate
+	 * expects. char * options become std::string_views into argv and
+	 * the usual number conversions become optnum, which uses
+	 * std::from_chars. Only the lines gengo writes are changed, a
+	 * "char * name;" member at the start of a line, option code that
+	 * is all of "opts.name = conversion;" or "optlistpush(&opts.name,
+	 * conversion);" and a few lines of defltTXT.c, so that the user's
+	 * own code is left as it is. Frees ufdata.
+	*/
+	static const char *convs[][2] = {
+		{ "strdup(optarg)", "optarg" },
+		{ "strtol(optarg, NULL, 10)", "optnum{optarg}" },
+		{ "strtoul(optarg, NULL, 10)", "optnum{optarg}" },
+		{ "strtod(optarg, NULL)", "optnum{optarg}" },
+		{ "atoi(optarg)", "optnum{optarg}" },
+		{ "atol(optarg)", "optnum{optarg}" },
+		{ "atof(optarg)", "optnum{optarg}" },
+		{ NULL, NULL }
+	};
+	static const char *lines[][2] = {
+		{ "static const char optstr[]",
+			"static constexpr char optstr[]" },
+		{ "options_t opts = { 0 };", "options_t opts = {};" },
+		{ NULL, NULL }
+	};
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	if (!fpres) {
+		perror("open_memstream");
+		exit(EXIT_FAILURE);
+	}
+	int copied = 0;	// the line before was a strdup(optarg)
+	char *cp = ufdata.from;
+	while (cp && cp < ufdata.to) {
+		char *eol = memchr(cp, '\n', ufdata.to - cp);
+		if (!eol) eol = ufdata.to;
+		size_t indent = strspn(cp, "\t ");
+		if (indent > (size_t)(eol - cp)) indent = eol - cp;
+		char *body = cp + indent;
+		size_t blen = eol - body;
+		int was = copied, i, done = 0;
+		copied = 0;
+		// the member name of "opts.name = " or "optlistpush(&opts.name, "
+		size_t pre = 0;
+		if (blen > 5 && memcmp(body, "opts.", 5) == 0) pre = 5;
+		else if (blen > 18 && memcmp(body, "optlistpush(&opts.", 18) == 0)
+			pre = 18;
+		size_t nlen = 0;
+		while (pre && pre + nlen < blen && (isalnum((unsigned char)
+				body[pre + nlen]) || body[pre + nlen] == '_')) nlen++;
+		const char *mid = (pre == 5) ? " = " : ", ";
+		const char *end = (pre == 5) ? ";" : ");";
+		size_t at = pre + nlen + strlen(mid);
+		if (indent == 0 && blen > 7 && memcmp(body, "char * ", 7) == 0
+			&& memchr(body, ';', blen) == body + blen - 1
+			&& !memchr(body, '(', blen)) {
+			fputs("std::string_view ", fpres);
+			fwrite(body + 7, 1, eol - body - 7, fpres);
+			done = 1;
+		} else if (pre && nlen && at < blen
+				&& memcmp(body + pre + nlen, mid, strlen(mid)) == 0) {
+			for (i = 0; !done && convs[i][0]; i++) {
+				size_t clen = strlen(convs[i][0]);
+				if (blen != at + clen + strlen(end)
+					|| memcmp(body + at, convs[i][0], clen) != 0
+					|| memcmp(body + at + clen, end, strlen(end)) != 0)
+					continue;
+				fwrite(cp, 1, at + indent, fpres);
+				fprintf(fpres, "%s%s", convs[i][1], end);
+				copied = (i == 0);
+				done = 1;
+			}
+		}
+		for (i = 0; !done && lines[i][0]; i++) {
+			size_t llen = strlen(lines[i][0]);
+			if (blen < llen || memcmp(body, lines[i][0], llen) != 0)
+				continue;
+			fwrite(cp, 1, indent, fpres);
+			fputs(lines[i][1], fpres);
+			fwrite(body + llen, 1, blen - llen, fpres);
+			done = 1;
+		}
+		// there is nothing allocated to count.
+		if (!done && was && blen == strlen("GTRACE_COUNT(allocs);")
+			&& memcmp(body, "GTRACE_COUNT(allocs);", blen) == 0) {
+			cp = eol + 1;
+			continue;
+		}
+		if (!done) fwrite(cp, 1, eol - cp, fpres);
+		if (eol < ufdata.to) fputc('\n', fpres);
+		cp = eol + 1;
+	}
+	fclose(fpres);
+	free(ufdata.from);
+	fdata out;
+	out.from = resbuf;
+	out.to = resbuf + reslen;
+	return out;
+} // cxxfilter()
+
+fdata memreplace(fdata in, const char *old, const char *new)
+{
+	/* Returns a copy of in with every old replaced by new, frees in. */
+	char *resbuf;
+	size_t reslen;
+	FILE *fpres = open_memstream(&resbuf, &reslen);
+	if (!fpres) {
+		perror("open_memstream");
+		exit(EXIT_FAILURE);
+	}
+	size_t oldlen = strlen(old);
+	char *cp = in.from;
+	while (cp < in.to) {
+		char *found = memmem(cp, in.to - cp, old, oldlen);
+		if (!found) found = in.to;
+		fwrite(cp, 1, found - cp, fpres);
+		if (found == in.to) break;
+		fputs(new, fpres);
+		cp = found + oldlen;
+	}
+	fclose(fpres);
+	free(in.from);
+	fdata out;
+	out.from = resbuf;
+	out.to = resbuf + reslen;
+	return out;
+} // memreplace()
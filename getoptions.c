@@ -20,6 +20,7 @@
 
 #include "getoptions.h"
 #include "fileops.h"
+#include "stats.h"
 
 static const char helpmsg[] =
 "\tUsage: gengo \n"
@@ -38,19 +39,100 @@ static const char helpmsg[] =
 " must\n"
 "\tbe in range 72..132. If outside range the number will be adjusted"
 " to the\n"
-"\tsmaller or larger number of this range. \n"
+"\tsmaller or larger number of this range. The generated program"
+" wraps\n"
+"\tits help to the terminal width and only uses this number when the"
+"\n\twidth can not be found. \n"
 "\t-d, --delete\n"
 "\tdeletes any workfiles found in the current directory. \n"
+"\t--stats[=json]\n"
+"\treport wall time, bytes read and written, and file opens and"
+" writes\n"
+"\tfor each phase of program generation. The report goes to stderr"
+" as a\n"
+"\ttable, or as JSON if json is given. \n"
+"\t--watch\n"
+"\tafter generating, keep watching the work files and boilerplate"
+" files\n"
+"\tand regenerate only the outputs affected by each change. Only"
+" used\n"
+"\twith -g. \n"
+"\t--record=file\n"
+"\twrite every answer given with -i to file, 1 per line. \n"
+"\t--replay=file\n"
+"\ttake the answers for -i from file, as written by --record, instead"
+" of\n"
+"\tasking for them. \n"
+"\t--selftest\n"
+"\ttreat the arguments as directories of work files. For each one"
+" generate\n"
+"\tthe program in a scratch dir, compile it, run it with -h and once"
+" with\n"
+"\teach option, then report pass or fail and the time taken. \n"
+"\t-j, --jobs\n"
+"\tthe number of --selftest directories to test at once. Default is"
+" 1. \n"
+"\t--cxx\n"
+"\twith -g, generate C++17 getoptions.hpp, getoptions.cpp and"
+" program_name.cpp\n"
+"\tfrom the C++ boilerplate files instead of C. \n"
+"\t--cache[=dir]\n"
+"\twith -g, look up the outputs in a cache keyed by a hash of the work"
+" files,\n"
+"\tthe boilerplate files, the settings and gengo, and restore them"
+" from it\n"
+"\tinstead of generating them when found. The default dir is"
+" $GENGO_CACHE_DIR\n"
+"\tor else $HOME/.cache/gengo. \n"
+"\t--profile=file\n"
+"\twith -g, put the long options table and the option cases in order"
+" of use,\n"
+"\tmost used first, from the counts in file. A program built with"
+" -DGENGO_PROFILE\n"
+"\tappends its counts to $GENGO_PROFILE or gengo.prof at exit. \n"
+"\t--amalgamate\n"
+"\twith -g, put getoptions.c at the end of getoptions.h behind #ifdef"
+" GETOPTIONS_IMPLEMENTATION,\n"
+"\twhich program_name.c defines, so the program is 1 translation unit."
+" \n"
+"\t--report[=text]\n"
+"\twith -g, print the size and padding of options_t, the bytes of the"
+" help text\n"
+"\tand option tables and the number of case blocks. With text also the"
+" .text\n"
+"\tof getoptions.o and what each option's case block adds to it. \n"
+"\t--lint\n"
+"\tcheck the work files in the current dir for options and members"
+" given twice\n"
+"\tand long names that can't be abbreviated, then exit. -g does this"
+" first. \n"
+"\t--multicall\n"
+"\twith -g progname dir..., generate the tool in each dir, named for"
+" the dir,\n"
+"\tthen progname.c and a makefile for 1 binary of all of them that"
+" runs\n"
+"\tthe tool it is called as, by its symlink in bin/. C only. \n"
+"\t--catalog\n"
+"\twith -g, leave the help text out of the program and write it to"
+" the\n"
+"\tcatalog progname.C.help, copies of which translate it, 1 per"
+" locale. \n"
+"\t--coldstart\n"
+"\twith -g, also write coldstart.c, coldstart.mk and coldstartTXT, to"
+" time\n"
+"\twhole runs of the program per build profile with make -f"
+" coldstart.mk. \n"
 ;
 
 
 options_t
 process_options(int argc, char **argv)
 {
-	static const char optstr[] = ":higc:d";
+	static const char optstr[] = ":higc:dj:";
 
 	options_t opts = { 0 };
 	opts.cols = 80;
+	opts.jobs = 1;
 
 	while (1) {
 		int this_option_optind = optind ? optind : 1;
@@ -61,6 +143,21 @@ process_options(int argc, char **argv)
 			{"generate",	0,	0,	'g'},
 			{"columns",	1,	0,	'c'},
 			{"delete",	0,	0,	'd'},
+			{"stats",	2,	0,	0 },
+			{"watch",	0,	0,	0 },
+			{"record",	1,	0,	0 },
+			{"replay",	1,	0,	0 },
+			{"selftest",	0,	0,	0 },
+			{"jobs",	1,	0,	'j'},
+			{"cxx",	0,	0,	0 },
+			{"cache",	2,	0,	0 },
+			{"profile",	1,	0,	0 },
+			{"amalgamate",	0,	0,	0 },
+			{"report",	2,	0,	0 },
+			{"lint",	0,	0,	0 },
+			{"multicall",	0,	0,	0 },
+			{"catalog",	0,	0,	0 },
+			{"coldstart",	0,	0,	0 },
 			{0,	0,	0,	0 }
 		};
 
@@ -71,6 +168,62 @@ process_options(int argc, char **argv)
 		switch (opt) {
 			case 0:
 				switch (option_index) {
+					case 5:
+						if (!optarg) opts.stats = STATS_TEXT;
+						else if (strcmp(optarg, "json") == 0)
+							opts.stats = STATS_JSON;
+						else {
+							fprintf(stderr, "Unknown stats format: %s\n",
+										optarg);
+							dohelp(1);
+						}
+						break;
+					case 6:
+						opts.watch = 1;
+						break;
+					case 7:
+						opts.record = strdup(optarg);
+						break;
+					case 8:
+						opts.replay = strdup(optarg);
+						break;
+					case 9:
+						opts.selftest = 1;
+						break;
+					case 11:
+						opts.cxx = 1;
+						break;
+					case 12:
+						opts.cache = strdup((optarg) ? optarg : "");
+						break;
+					case 13:
+						opts.profile = strdup(optarg);
+						break;
+					case 14:
+						opts.amalgamate = 1;
+						break;
+					case 15:
+						if (!optarg) opts.report = 1;
+						else if (strcmp(optarg, "text") == 0)
+							opts.report = 2;
+						else {
+							fprintf(stderr, "Unknown report: %s\n",
+										optarg);
+							dohelp(1);
+						}
+						break;
+					case 16:
+						opts.lint = 1;
+						break;
+					case 17:
+						opts.multicall = 1;
+						break;
+					case 18:
+						opts.catalog = 1;
+						break;
+					case 19:
+						opts.coldstart = 1;
+						break;
 				} // switch(option_index)
 				break;
 			case 'h':
@@ -85,6 +238,9 @@ process_options(int argc, char **argv)
 			case 'c':
 				opts.cols = strtol(optarg, NULL, 10);
 				break;
+			case 'j':
+				opts.jobs = strtol(optarg, NULL, 10);
+				break;
 			case 'd':
 				if (fileexists("helpTXT.c") == 0) unlink("helpTXT.c");
 				if (fileexists("usageTXT.c") == 0) unlink("usageTXT.c");
@@ -98,6 +254,10 @@ process_options(int argc, char **argv)
 					unlink("lostructTXT.c");
 				if (fileexists("noargsTXT.c") == 0)
 					unlink("noargsTXT.c");
+				if (fileexists("constrTXT.c") == 0)
+					unlink("constrTXT.c");
+				if (fileexists("lazyTXT.c") == 0) unlink("lazyTXT.c");
+				if (fileexists("lazyTXT.h") == 0) unlink("lazyTXT.h");
 				exit(EXIT_SUCCESS);
 				break;
 			case ':':
@@ -37,6 +37,21 @@ typedef struct options_ {
 	int inter;
 	int gen;
 	int cols;
+	int stats;
+	int watch;
+	char *record;
+	char *replay;
+	int selftest;
+	int jobs;
+	int cxx;
+	char *cache;
+	char *profile;
+	int amalgamate;
+	int report;
+	int lint;
+	int multicall;
+	int catalog;
+	int coldstart;
 } options_t;
 
 void dohelp(int forced);
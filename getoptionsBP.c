@@ -20,24 +20,177 @@
 */
 
 #include "getoptions.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <ctype.h>
+#include <limits.h>
+#include <linux/limits.h>
+#include <libgen.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#if (defined(GENGO_STAT_THREADS) && GENGO_STAT_THREADS > 1) \
+	|| defined(GENGO_RELOAD)
+#include <pthread.h>
+#endif
+#ifdef GENGO_RELOAD
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+#ifdef GENGO_CATALOG
+#include <sys/mman.h>
+#include <locale.h>
+#include <wchar.h>
+#endif
+#ifdef GENGO_BULK
+#include <setjmp.h>
+#endif
+#ifdef GENGO_TRACE
+#include <time.h>
+#ifdef GENGO_TRACE_USDT
+#include <sys/sdt.h>
+#endif
+#endif
 
+/* Help for each option is kept as 1 line of text plus its part of
+ * helpbrk[], the byte offset and display column at the end of each
+ * word. */
+typedef struct helppara {
+	const char *opt;	// -x, --longx
+	const char *text;
+	const unsigned short (*brk)[2];
+	unsigned short nbrk;
+} helppara;
+
+static int helpwidth(void);
+static void helpline(const char *text, int len);
+#ifdef GENGO_CATALOG
+/* Built with -DGENGO_CATALOG the help is not in the program but in
+ * catalogs, helpname.<locale>.help, 1 per locale, mapped only when the
+ * help is shown. */
+static const char *helpcatalog(size_t *lenp);
+static void helpwrap(const char *from, const char *to, int wid);
+#endif
+
+/* <PROG>_<LONGNAME> environment variables, or <PROG>_<MEMBER> for a
+ * short option, gengo writes envtab[] as a hash table with linear
+ * probing. */
+typedef struct envbind {
+	const char *name;	// LONGNAME or MEMBER
+	const char *opt;	// --longname or -c
+	int hasarg;
+} envbind;
+static char **envoptions(int *argcp, char **argv, int *nenv);
+static unsigned envhash(const char *name, size_t len);
+
+/* Conflicts, requires and oneof rules between options, gengo writes
+ * optrulemask[] and co from constrTXT.c. */
+static void optmark(int opt, int index);
+static void optcheck(void);
+
+/* Option use counts, compiled in with -DGENGO_PROFILE. long_options[]
+ * may be in profile order, OPTORIG() gives the index gengo -i made. */
+#ifdef GENGO_PROFILE
+static void gengo_profile_count(int opt, const struct option *lo,
+								int index);
+#define GPROFILE_COUNT(opt, lo, index)	gengo_profile_count(opt, lo, index)
+#else
+#define GPROFILE_COUNT(opt, lo, index)	((void)0)
+#endif
+
+#ifdef GENGO_BULK
+/* While optparseone() runs process_options() each way out that would
+ * show the help and exit jumps back to it with an OPTS_* code instead,
+ * after freeing what the options parsed so far hold. */
+static jmp_buf *optbail;
+static options_t *optpartial;	// process_options()' opts
+#define OPTBAIL(code)	do { if (optbail) { \
+							if (optpartial) options_dispose(optpartial); \
+							longjmp(*optbail, (code)); } } while (0)
+#define OPTBULK	(optbail != NULL)
+/* The strdup(optarg) of an option's code keeps optarg itself while
+ * optparseone() runs, so a record's strings are the caller's and a
+ * record that fails leaves nothing to free but its lists. */
+static inline char *optdup(const char *s)
+{
+	return (OPTBULK && s == optarg) ? (char *)s : strdup(s);
+}
+#undef strdup
+#define strdup(s)	optdup(s)
+#else
+#define OPTBAIL(code)	((void)0)
+#define OPTBULK	0
+#endif
+
+/* The optarg kept for an opt_<var>() accessor, as the C string its
+ * conversion code is given. */
+static inline const char *optargstr(const char *s)
+{
+	return s;
+}
+
+/* Helpers for options_serialize() and options_deserialize(), which
+ * gengo writes from the members of options_t. Unused is not an error,
+ * as not every options_t has strings or lists. */
+#define OPTU	__attribute__((unused))
+#ifdef GENGO_SERIAL
+#define OPTS_HEADER	12
+static OPTU void optsheader(char *buf, size_t size, uint32_t layout,
+				size_t total);
+static OPTU size_t optscheck(const char *buf, size_t len,
+				uint32_t layout);
+static OPTU size_t optput(char *buf, size_t size, size_t off,
+				const void *v, size_t len);
+static OPTU size_t optputstr(char *buf, size_t size, size_t off,
+				const char *s);
+static OPTU size_t optputlist(char *buf, size_t size, size_t off,
+				const optlist *l);
+static OPTU size_t optget(char *buf, size_t len, size_t off, void *v,
+				size_t vlen);
+static OPTU size_t optgetstr(char *buf, size_t len, size_t off,
+				char **s);
+static OPTU size_t optgetlist(char *buf, size_t len, size_t off,
+				optlist *l);
+#endif
+static OPTU void optfreelist(optlist *l);
+
+#ifndef GENGO_CATALOG
 static const char helpmsg[] =
 //</preamble>
 //<fixedoptions>
   "\n\tOptions:\n"
   "\t-h, --help\n\tDisplays this help message, then quits.\n"
+  ;
+
 //</fixedoptions>
+//<endhelp>
+#else
+static const char helpname[] = "progname";
+#endif
+//</endhelp>
 
 //<endoptions>
-  ;
-
 options_t
 process_options(int argc, char **argv)
 {
+	GTRACE_MARK(GT_START);
 
 //</endoptions>
 //<golongwshortpre>
+	GTRACE_MARK(GT_DEFAULTS);
+#ifdef GENGO_BULK
+	optpartial = &opts;
+#endif
 
+	char **oargv = argv;
+	int nenv;
+	argv = envoptions(&argc, argv, &nenv);
 	int opt;
 
 	while (1) {
@@ -54,6 +207,11 @@ process_options(int argc, char **argv)
 							&option_index);
 		if (opt == -1)
 			break;
+		GTRACE_COUNT(options);
+		GPROFILE_COUNT(opt, long_options, option_index);
+		option_index = OPTORIG(option_index);
+		// the rules are for the command line, not the environment.
+		if (this_option_optind > nenv) optmark(opt, option_index);
 //</golongwshortpost>
 //<glongonlypre>
 		switch (opt) {
@@ -71,11 +229,13 @@ process_options(int argc, char **argv)
 //</glshortspre>
 //<glshortspost>
 			case ':':
+				OPTBAIL(OPTS_NOARG);
 				fprintf(stderr, "Option %s requires an argument\n",
 							argv[this_option_optind]);
 				dohelp(1);
 				break;
 			case '?':
+				OPTBAIL(OPTS_UNKNOWN);
 				fprintf(stderr, "Unknown option: %s\n",
 								argv[this_option_optind]);
 				dohelp(1);
@@ -83,14 +243,915 @@ process_options(int argc, char **argv)
 		}
 
 	} // while(1)
+	if (nenv) {	// give back argv as getopt_long() would have left it.
+		memcpy(oargv + 1, argv + 1 + nenv,
+				(argc - nenv - 1) * sizeof(char *));
+		free(argv);
+		optind -= nenv;
+	}
+	optcheck();
+	GTRACE_MARK(GT_PARSE);
 	return opts;
 } // process_options()
 //</glshortspost>
 //<tail>
 
+#ifndef GENGO_CATALOG
 void dohelp(int forced)
 {
-  fputs(helpmsg, stderr);
-  exit(forced);
+	OPTBAIL((forced) ? OPTS_BAD : OPTS_HELP);
+	fputs(helpmsg, stderr);
+	int wid = helpwidth() - 8;	// help text is indented by a tab.
+	if (wid < 20) wid = 20;
+	const helppara *hp;
+	for (hp = helptab; hp->opt; hp++) {
+		fprintf(stderr, "\t%s\n", hp->opt);
+		/* Break before any word that would end past wid, 1 pass over
+		 * the break table. */
+		int bol = 0, bolcol = 0, first = 0, k;
+		for (k = 0; k < hp->nbrk; k++) {
+			if (k > first && hp->brk[k][1] - bolcol > wid) {
+				helpline(hp->text + bol, hp->brk[k-1][0] - bol);
+				bol = hp->brk[k-1][0] + 1;
+				bolcol = hp->brk[k-1][1] + 1;
+				first = k;
+			}
+		}
+		if (hp->nbrk) helpline(hp->text + bol, hp->brk[k-1][0] - bol);
+	}
+	exit(forced);
+}
+#else
+void dohelp(int forced)
+{	/* Shows the catalog for the locale, each tab indented line wider
+	 * than the terminal wrapped at its spaces. */
+	OPTBAIL((forced) ? OPTS_BAD : OPTS_HELP);
+	size_t len;
+	const char *cat = helpcatalog(&len);
+	if (!cat) {
+		fprintf(stderr, "\tNo help, %s.C.help is not installed.\n",
+					helpname);
+		exit(forced);
+	}
+	int wid = helpwidth() - 8;	// help text is indented by a tab.
+	if (wid < 20) wid = 20;
+	setlocale(LC_CTYPE, "");	// for wcwidth(), dohelp() exits.
+	const char *cp = cat, *end = cat + len;
+	while (cp < end) {
+		const char *eol = memchr(cp, '\n', end - cp);
+		if (!eol) eol = end;
+		if (*cp == '\t') {
+			helpwrap(cp + 1, eol, wid);
+		} else {
+			fprintf(stderr, "%.*s\n", (int)(eol - cp), cp);
+		}
+		cp = eol + 1;
+	}
+	exit(forced);	// the mapping goes with the process.
+}
+
+const char *helpcatalog(size_t *lenp)
+{	/* Maps the catalog for LC_ALL, LC_MESSAGES or LANG, ll_CC then ll
+	 * then C, from $GENGO_HELPDIR, the GENGO_HELPDIR it was built with
+	 * or the dir the program is in. NULL if none of them has one.
+	*/
+	const char *vars[] = { "LC_ALL", "LC_MESSAGES", "LANG" };
+	char loc[3][64] = { "", "", "C" };
+	int i, l;
+	for (i = 0; i < 3 && !loc[0][0]; i++) {
+		const char *v = getenv(vars[i]);
+		if (v) snprintf(loc[0], sizeof loc[0], "%s", v);
+	}
+	loc[0][strcspn(loc[0], ".@")] = '\0';	// no codeset or modifier
+	if (strcmp(loc[0], "POSIX") == 0) loc[0][0] = '\0';
+	if (strchr(loc[0], '_')) {
+		strcpy(loc[1], loc[0]);
+		loc[1][strcspn(loc[1], "_")] = '\0';
+	}
+	char dirs[3][PATH_MAX];	// not initialised, that's 12k of rodata.
+	dirs[0][0] = dirs[1][0] = dirs[2][0] = '\0';
+	if (getenv("GENGO_HELPDIR"))
+		snprintf(dirs[0], PATH_MAX, "%s", getenv("GENGO_HELPDIR"));
+#ifdef GENGO_HELPDIR
+	snprintf(dirs[1], PATH_MAX, "%s", GENGO_HELPDIR);
+#endif
+	ssize_t n = readlink("/proc/self/exe", dirs[2], PATH_MAX - 1);
+	if (n > 0) {
+		dirs[2][n] = '\0';
+		*strrchr(dirs[2], '/') = '\0';
+	}
+	for (i = 0; i < 3; i++) {
+		for (l = 0; l < 3; l++) {
+			if (!dirs[i][0] || !loc[l][0]) continue;
+			char path[PATH_MAX + sizeof helpname + sizeof loc[0] + 8];
+			if (snprintf(path, sizeof path, "%s/%s.%s.help", dirs[i],
+						helpname, loc[l]) >= (int)sizeof path)
+				continue;	// can't be opened anyway.
+			int fd = open(path, O_RDONLY | O_CLOEXEC);
+			if (fd == -1) continue;
+			struct stat sb;
+			void *map = MAP_FAILED;
+			if (fstat(fd, &sb) == 0 && sb.st_size > 0)
+				map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (map == MAP_FAILED) continue;
+			*lenp = sb.st_size;
+			return map;
+		}
+	}
+	return NULL;
+} // helpcatalog()
+
+void helpwrap(const char *from, const char *to, int wid)
+{	/* helpline()s of the text from..to, broken at the space before
+	 * any word that would end past wid columns, each character as wide
+	 * as wcwidth() has it in the locale. Where mbrtowc() can't read
+	 * it, as in the C locale, a UTF-8 character is a column. */
+	const char *bol = from, *brk = NULL, *cp = from;
+	int col = 0, brkcol = 0;
+	mbstate_t st;
+	memset(&st, 0, sizeof st);
+	while (cp < to) {
+		if (*cp == ' ') {
+			brk = cp;
+			brkcol = col;
+		}
+		wchar_t wc;
+		size_t n = mbrtowc(&wc, cp, to - cp, &st);
+		int w;
+		if (n == (size_t)-1 || n == (size_t)-2) {
+			memset(&st, 0, sizeof st);
+			n = 1;
+			w = (((unsigned char)*cp & 0xC0) != 0x80);
+		} else {
+			if (n == 0) n = 1;
+			w = wcwidth(wc);
+			if (w < 0) w = 1;
+		}
+		cp += n;
+		col += w;
+		if (col > wid && brk) {
+			helpline(bol, brk - bol);
+			bol = brk + 1;
+			col -= brkcol + 1;
+			brk = NULL;
+		}
+	}
+	helpline(bol, to - bol);
+} // helpwrap()
+#endif
+
+int helpwidth(void)
+{	/* Width of the terminal that help goes to, or $COLUMNS, or else
+	 * the width given to gengo at generation time. */
+	struct winsize ws;
+	if (ioctl(STDERR_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0)
+		return ws.ws_col;
+	char *cp = getenv("COLUMNS");
+	int cols = (cp) ? atoi(cp) : 0;
+	return (cols > 0) ? cols : helpcols;
+}
+
+void helpline(const char *text, int len)
+{
+	fprintf(stderr, "\t%.*s\n", len, text);
 }
+
+char **envoptions(int *argcp, char **argv, int *nenv)
+{
+	/* Walks environ once looking up each <PROG>_ variable in envtab[]
+	 * and returns a copy of argv with the matching options put ahead
+	 * of argv's own, so that argv's own take precedence. Flags are set
+	 * by any value but "" or "0". Returns argv itself if nothing
+	 * matched, else *nenv is the number of args added.
+	*/
+	*nenv = 0;
+	if (OPTBULK) return argv;	// not the environment argv came from.
+	size_t plen = strlen(envprefix);
+	char **nargv = NULL;
+	int n = 0;
+	char **ep;
+	for (ep = environ; *ep; ep++) {
+		if (strncmp(*ep, envprefix, plen) != 0) continue;
+		const char *name = *ep + plen;
+		const char *eq = strchr(name, '=');
+		if (!eq) continue;
+		size_t len = eq - name;
+		unsigned h = envhash(name, len) & (ENVTABSIZE - 1);
+		while (envtab[h].name && (strlen(envtab[h].name) != len
+				|| memcmp(envtab[h].name, name, len) != 0))
+			h = (h + 1) & (ENVTABSIZE - 1);
+		if (!envtab[h].name) continue;
+		if (n + 2 > 2 * ENVTABSIZE) break;	// duplicated in environ
+		if (!nargv) {
+			nargv = (char **)malloc((*argcp + 2 * ENVTABSIZE + 1)
+									* sizeof(char *));
+			if (!nargv) {
+				perror("envoptions");
+				exit(EXIT_FAILURE);
+			}
+		}
+		if (envtab[h].hasarg) {
+			nargv[1 + n++] = (char *)envtab[h].opt;
+			nargv[1 + n++] = (char *)eq + 1;
+		} else if (eq[1] && strcmp(eq + 1, "0") != 0) {
+			nargv[1 + n++] = (char *)envtab[h].opt;
+		}
+	}
+	*nenv = n;
+	if (!n) {
+		free(nargv);
+		return argv;
+	}
+	nargv[0] = argv[0];
+	memcpy(nargv + 1 + n, argv + 1, *argcp * sizeof(char *));	// + NULL
+	*argcp += n;
+	return nargv;
+} // envoptions()
+
+unsigned envhash(const char *name, size_t len)
+{	// FNV-1a, gengo hashes envtab[] with the same function.
+	unsigned h = 2166136261u;
+	while (len--) h = (h ^ (unsigned char)*name++) * 16777619u;
+	return h;
+} // envhash()
+
+void optmark(int opt, int index)
+{	/* Sets the bit in optseen[] of the option getopt_long() returned,
+	 * short options by their place in optbitchars[], long only options
+	 * after them by index. */
+	int bit;
+	if (opt == 0) {
+		bit = (int)strlen(optbitchars) + index;
+	} else {
+		const char *cp = strchr(optbitchars, opt);
+		if (!cp) return;	// ':' or '?'
+		bit = cp - optbitchars;
+	}
+	if (bit < 64 * OPTWORDS) optseen[bit / 64] |= 1ULL << (bit % 64);
+} // optmark()
+
+void optcheck(void)
+{	/* Checks every rule in optrulemask[] against optseen[], a few
+	 * word wide ANDs each whatever the option count, and reports all
+	 * that are broken before giving the help.
+	 *  c  the option in mask 0 conflicts with those in mask 1.
+	 *  r  the option in mask 0 requires all of those in mask 1.
+	 *  o  exactly one of the options in mask 0.
+	*/
+	int r, w, broken = 0;
+	for (r = 0; optrulekind[r]; r++) {
+		unsigned long long a = 0, b = 0, missing = 0;
+		int n = 0;
+		for (w = 0; w < OPTWORDS; w++) {
+			unsigned long long sa = optseen[w] & optrulemask[r][0][w];
+			unsigned long long sb = optseen[w] & optrulemask[r][1][w];
+			a |= sa;
+			b |= sb;
+			missing |= sb ^ optrulemask[r][1][w];
+			n += __builtin_popcountll(sa);
+		}
+		if ((optrulekind[r] == 'c' && a && b)
+			|| (optrulekind[r] == 'r' && a && missing)
+			|| (optrulekind[r] == 'o' && n != 1)) {
+			OPTBAIL(OPTS_RULE);
+			fprintf(stderr, "Options: %s\n", optrulemsg[r]);
+			broken++;
+		}
+	}
+	if (broken) dohelp(1);
+} // optcheck()
+
+#ifdef GENGO_SERIAL
+/* options_serialize() and options_deserialize(). The format is "gopt",
+ * the layout of options_t and the total length, 4 bytes each, then
+ * each member in declaration order: arithmetic types as their bytes,
+ * strings as a 4 byte length, the bytes and a '\0' and lists as a
+ * 4 byte count of strings. NULL strings have length UINT32_MAX. All of
+ * it is in the byte order of the machine. Each function takes and
+ * returns the offset in buf, SIZE_MAX once buf has proved bad.
+*/
+size_t options_size(const char *buf)
+{
+	/* The total length from the 12 byte header at buf, so a reader
+	 * knows how much more to read. */
+	uint32_t len;
+	if (memcmp(buf, "gopt", 4) != 0) return 0;
+	memcpy(&len, buf + 8, sizeof len);
+	return len;
+} // options_size()
+
+void optsheader(char *buf, size_t size, uint32_t layout, size_t total)
+{
+	/* Writes the header for total bytes, if it fits. */
+	uint32_t hdr[2] = { layout, (uint32_t)total };
+	if (size >= OPTS_HEADER) {
+		memcpy(buf, "gopt", 4);
+		memcpy(buf + 4, hdr, sizeof hdr);
+	}
+} // optsheader()
+
+size_t optscheck(const char *buf, size_t len, uint32_t layout)
+{
+	/* The offset of the first member if the header at buf is for len
+	 * bytes of this layout. */
+	uint32_t hdr[2] = { layout, (uint32_t)len };
+	if (len < OPTS_HEADER || memcmp(buf, "gopt", 4) != 0
+		|| memcmp(buf + 4, hdr, sizeof hdr) != 0) return SIZE_MAX;
+	return OPTS_HEADER;
+} // optscheck()
+
+size_t optput(char *buf, size_t size, size_t off, const void *v,
+				size_t len)
+{
+	if (off + len <= size) memcpy(buf + off, v, len);
+	return off + len;
+} // optput()
+
+size_t optputstr(char *buf, size_t size, size_t off, const char *s)
+{
+	uint32_t len = (s) ? (uint32_t)strlen(s) : UINT32_MAX;
+	off = optput(buf, size, off, &len, sizeof len);
+	if (s) off = optput(buf, size, off, s, len + 1);
+	return off;
+} // optputstr()
+
+size_t optputlist(char *buf, size_t size, size_t off, const optlist *l)
+{
+	uint32_t n = (uint32_t)l->n;
+	size_t i;
+	off = optput(buf, size, off, &n, sizeof n);
+	for (i = 0; i < l->n; i++) off = optputstr(buf, size, off, l->v[i]);
+	return off;
+} // optputlist()
+
+size_t optget(char *buf, size_t len, size_t off, void *v, size_t vlen)
+{
+	if (off > len || len - off < vlen) return SIZE_MAX;
+	memcpy(v, buf + off, vlen);
+	return off + vlen;
+} // optget()
+
+size_t optgetstr(char *buf, size_t len, size_t off, char **s)
+{
+	/* *s points into buf, which must outlive it. */
+	uint32_t n;
+	*s = NULL;
+	off = optget(buf, len, off, &n, sizeof n);
+	if (off == SIZE_MAX || n == UINT32_MAX) return off;
+	if (len - off <= n || buf[off + n] != '\0') return SIZE_MAX;
+	*s = buf + off;
+	return off + n + 1;
+} // optgetstr()
+
+size_t optgetlist(char *buf, size_t len, size_t off, optlist *l)
+{
+	/* l->v is allocated, its strings point into buf. */
+	uint32_t n, i;
+	off = optget(buf, len, off, &n, sizeof n);
+	// each string takes at least 5 bytes.
+	if (off == SIZE_MAX || n > (len - off) / 5) return SIZE_MAX;
+	l->v = (char **)malloc((n + 1) * sizeof(char *));
+	if (!l->v) {
+		perror("optgetlist");
+		exit(EXIT_FAILURE);
+	}
+	l->n = n;
+	l->cap = n + 1;
+	for (i = 0; i < n && off != SIZE_MAX; i++)
+		off = optgetstr(buf, len, off, &l->v[i]);
+	l->v[n] = NULL;
+	if (off == SIZE_MAX) {
+		free(l->v);
+		memset(l, 0, sizeof *l);
+	}
+	return off;
+} // optgetlist()
+#endif
+
+void optfreelist(optlist *l)
+{
+	free(l->v);
+	memset(l, 0, sizeof *l);
+} // optfreelist()
+
+void optlistpush(optlist *l, char *s)
+{	/* Appends s to l, doubling the room in l when it is full so that
+	 * n uses of an option cost O(n) and O(log n) realloc()s. */
+	if (l->n + 1 >= l->cap) {
+		size_t cap = (l->cap) ? 2 * l->cap : 8;
+		char **v = (char **)realloc(l->v, cap * sizeof(char *));
+		if (!v) {
+			perror("optlistpush");
+			exit(EXIT_FAILURE);
+		}
+		l->v = v;
+		l->cap = cap;
+	}
+	l->v[l->n++] = s;
+	l->v[l->n] = NULL;
+} // optlistpush()
+
+/* Non-option argument checking. kinds has 1 char per argument,
+ * 'd' a dir, 'f' a file, 's' a string, '?' anything, and a final 'F'
+ * means all the remaining arguments are files. */
+typedef struct statjob {
+	char **paths;
+	const char *kinds;
+	int *errs;	// 0, an errno, or -1 for not a regular file.
+	int n;
+} statjob;
+
+static void *statpaths(void *arg)
+{
+	statjob *job = (statjob *)arg;
+	int i;
+	for (i = 0; i < job->n; i++) {
+		char k = job->kinds[i];
+		struct stat sb;
+		job->errs[i] = 0;
+		if (k != 'd' && k != 'f' && k != 'F') continue;
+		if (fstatat(AT_FDCWD, job->paths[i], &sb, 0) == -1)
+			job->errs[i] = errno;
+		else if (k == 'd' && !S_ISDIR(sb.st_mode))
+			job->errs[i] = ENOTDIR;
+		else if (k != 'd' && !S_ISREG(sb.st_mode))
+			job->errs[i] = -1;
+	}
+	return NULL;
+}
+
+int checkargs(int argc, char **argv, int first, const char *kinds)
+{
+	/* Checks all the non-option arguments from argv[first] in 1 pass
+	 * and reports every missing or bad one before calling dohelp().
+	 * Build with -DGENGO_STAT_THREADS=n to stat long lists of files
+	 * on n threads. Returns the index of the next argument. */
+	int nkinds = strlen(kinds);
+	int rest = (nkinds && kinds[nkinds - 1] == 'F');
+	int nfixed = nkinds - rest;
+	int bad = 0, i;
+	for (i = argc - first; i < nfixed; i++) {	// the missing ones.
+		char k = kinds[i];
+		fprintf(stderr, "No %s provided.\n", (k == 'd') ? "dir"
+					: (k == 'f') ? "file" : (k == 's') ? "string"
+					: "argument");
+		bad++;
+	}
+	int n = (rest || argc - first < nfixed) ? argc - first : nfixed;
+	char *argk = (char *)malloc(n + 1);
+	int *errs = (int *)calloc(n + 1, sizeof(int));
+	if (!argk || !errs) {
+		perror("checkargs");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < n; i++) argk[i] = (i < nfixed) ? kinds[i] : 'F';
+	statjob job;
+	job.paths = argv + first;
+	job.kinds = argk;
+	job.errs = errs;
+	job.n = n;
+#if defined(GENGO_STAT_THREADS) && GENGO_STAT_THREADS > 1
+	if (n >= 64) {
+		pthread_t tids[GENGO_STAT_THREADS];
+		statjob jobs[GENGO_STAT_THREADS];
+		int started[GENGO_STAT_THREADS];
+		int per = (n + GENGO_STAT_THREADS - 1) / GENGO_STAT_THREADS;
+		int t;
+		for (t = 0; t < GENGO_STAT_THREADS; t++) {
+			int from = (t * per < n) ? t * per : n;
+			jobs[t] = job;
+			jobs[t].paths += from;
+			jobs[t].kinds += from;
+			jobs[t].errs += from;
+			jobs[t].n = (n - from < per) ? n - from : per;
+			started[t] = !pthread_create(&tids[t], NULL, statpaths,
+											&jobs[t]);
+			if (!started[t]) statpaths(&jobs[t]);
+		}
+		for (t = 0; t < GENGO_STAT_THREADS; t++)
+			if (started[t]) pthread_join(tids[t], NULL);
+	} else
+#endif
+	statpaths(&job);
+	for (i = 0; i < n; i++) {
+		if (!errs[i]) continue;
+		fprintf(stderr, "%s: %s\n", argv[first + i], (errs[i] == -1)
+					? "Not a regular file" : strerror(errs[i]));
+		bad++;
+	}
+	free(argk);
+	free(errs);
+	if (bad) dohelp(1);
+	return first + n;
+}
+
+#ifdef GENGO_RELOAD
+/* Hot reload. Each reload runs process_options() in a child on the
+ * words of the config file ahead of the saved argv and reads back the
+ * options_serialize() of the result, so a bad config costs the child
+ * and not the daemon. The new snapshot is published by swapping
+ * optcur. Readers count themselves in optreaders[] of the epoch they
+ * started in, starting again if it flipped meanwhile; after the swap
+ * the epoch flips and the old snapshot is freed once the old epoch's
+ * count drains to 0. Only the reloading thread ever waits. Every
+ * snapshot has its lazy options converted by options_convert() before
+ * it is published, so readers read opts->var itself and never call
+ * opt_var(), which would write to a snapshot other threads share.
+*/
+typedef struct optsnap {
+	options_t opts;
+	char *buf;	// from options_serialize(), the strings in opts.
+} optsnap;
+
+static optsnap optfirst;	// from the caller's process_options()
+static optsnap *optcur = &optfirst;
+static unsigned optepoch;
+static struct optcount {
+	long n;
+} __attribute__((aligned(64))) optreaders[2];	// a cache line each
+static int reloadargc;
+static char **reloadargv;
+static const char *reloadconfig;
+static int hupfd[2];
+static pthread_mutex_t reloadlock = PTHREAD_MUTEX_INITIALIZER;
+
+static void reloadchild(int fd);
+static void onhup(int sig);
+static void *reloader(void *arg);
+
+void options_reload_init(const options_t *opts, int argc, char **argv,
+							const char *config)
+{
+	/* Makes *opts the first snapshot and reloads on every SIGHUP.
+	 * argv must outlive the program, config may be NULL. Call it
+	 * before starting any other thread.
+	*/
+	optfirst.opts = *opts;
+	options_convert(&optfirst.opts);
+	reloadargc = argc;
+	reloadargv = argv;
+	reloadconfig = config;
+	if (pipe(hupfd) == -1) {
+		perror("pipe");
+		exit(EXIT_FAILURE);
+	}
+	pthread_t tid;
+	int err = pthread_create(&tid, NULL, reloader, NULL);
+	if (err) {
+		fprintf(stderr, "pthread_create: %s\n", strerror(err));
+		exit(EXIT_FAILURE);
+	}
+	pthread_detach(tid);
+	struct sigaction sa;
+	memset(&sa, 0, sizeof sa);
+	sa.sa_handler = onhup;
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGHUP, &sa, NULL);
+} // options_reload_init()
+
+const options_t *options_acquire(int *token)
+{
+	/* The current options, valid until options_release(*token). No
+	 * locks, an atomic add and a load of the epoch. A reload may flip
+	 * the epoch between its load and the add, then wait on the other
+	 * count and free what this reader is about to load, so the count
+	 * is only kept if the epoch is still the same after it. */
+	int e;
+	for (;;) {
+		e = __atomic_load_n(&optepoch, __ATOMIC_SEQ_CST) & 1;
+		__atomic_fetch_add(&optreaders[e].n, 1, __ATOMIC_SEQ_CST);
+		if ((int)(__atomic_load_n(&optepoch, __ATOMIC_SEQ_CST) & 1) == e)
+			break;
+		__atomic_fetch_sub(&optreaders[e].n, 1, __ATOMIC_SEQ_CST);
+	}
+	*token = e;
+	return &__atomic_load_n(&optcur, __ATOMIC_SEQ_CST)->opts;
+} // options_acquire()
+
+void options_release(int token)
+{
+	__atomic_fetch_sub(&optreaders[token].n, 1, __ATOMIC_SEQ_CST);
+} // options_release()
+
+int options_reload(void)
+{
+	/* Parses the config and argv again and publishes the result.
+	 * Returns 0, or -1 leaving the options as they were if the parse
+	 * failed.
+	*/
+	pthread_mutex_lock(&reloadlock);
+	int fd[2];
+	if (pipe(fd) == -1) {
+		pthread_mutex_unlock(&reloadlock);
+		return -1;
+	}
+	fflush(NULL);	// or the child's exit() flushes it again.
+	pid_t pid = fork();
+	if (pid == 0) {
+		close(fd[0]);
+		reloadchild(fd[1]);
+	}
+	close(fd[1]);
+	size_t len = 0, room = 4096;
+	char *buf = (char *)malloc(room);
+	ssize_t got = 0;
+	while (buf && pid > 0
+			&& (got = read(fd[0], buf + len, room - len)) != 0) {
+		if (got == -1 && errno == EINTR) continue;
+		if (got == -1) break;
+		len += got;
+		if (len < room) continue;
+		char *more = (char *)realloc(buf, room *= 2);
+		if (!more) free(buf);
+		buf = more;
+	}
+	close(fd[0]);
+	int status = -1;
+	if (pid > 0) waitpid(pid, &status, 0);
+	optsnap *snap = (optsnap *)calloc(1, sizeof *snap);
+	if (!buf || !snap || got < 0 || status != 0
+		|| options_deserialize(&snap->opts, buf, len) == -1) {
+		free(buf);
+		free(snap);
+		pthread_mutex_unlock(&reloadlock);
+		return -1;
+	}
+	snap->buf = buf;
+	options_convert(&snap->opts);	// the child saw that it can be.
+	optsnap *old = __atomic_exchange_n(&optcur, snap, __ATOMIC_SEQ_CST);
+	int e = __atomic_fetch_xor(&optepoch, 1, __ATOMIC_SEQ_CST) & 1;
+	while (__atomic_load_n(&optreaders[e].n, __ATOMIC_SEQ_CST))
+		usleep(100);
+	if (old != &optfirst) {
+		options_dispose(&old->opts);
+		free(old->buf);
+		free(old);
+	}
+	pthread_mutex_unlock(&reloadlock);
+	return 0;
+} // options_reload()
+
+void reloadchild(int fd)
+{
+	/* In the child, parses the config words and then argv and writes
+	 * the serialized result to fd. Never returns. */
+	char **nargv = (char **)malloc((reloadargc + 1) * sizeof(char *));
+	int n = 0, i;
+	if (!nargv) _exit(EXIT_FAILURE);
+	nargv[n++] = reloadargv[0];
+	FILE *fp = (reloadconfig) ? fopen(reloadconfig, "r") : NULL;
+	char *line = NULL;
+	size_t linesz = 0;
+	while (fp && getline(&line, &linesz, fp) != -1) {
+		char *save, *word;
+		if (line[strspn(line, " \t")] == '#') continue;
+		for (word = strtok_r(line, " \t\n", &save); word;
+				word = strtok_r(NULL, " \t\n", &save)) {
+			nargv = (char **)realloc(nargv,
+								(n + reloadargc + 1) * sizeof(char *));
+			if (!nargv) _exit(EXIT_FAILURE);
+			nargv[n++] = strdup(word);
+		}
+		line = NULL;	// the words are kept.
+		linesz = 0;
+	}
+	if (fp) fclose(fp);
+	for (i = 1; i < reloadargc; i++) nargv[n++] = reloadargv[i];
+	nargv[n] = NULL;
+	optind = 0;	// getopt_long() starts over.
+	memset(optseen, 0, sizeof optseen);
+	options_t opts = process_options(n, nargv);
+	options_convert(&opts);	// a bad value exits here, not in the parent.
+	size_t len = options_serialize(&opts, NULL, 0);
+	char *buf = (char *)malloc(len);
+	if (!buf) _exit(EXIT_FAILURE);
+	options_serialize(&opts, buf, len);
+	char *cp = buf;
+	while (len) {
+		ssize_t put = write(fd, cp, len);
+		if (put <= 0) _exit(EXIT_FAILURE);
+		cp += put;
+		len -= put;
+	}
+	_exit(EXIT_SUCCESS);
+} // reloadchild()
+
+void onhup(int sig)
+{
+	(void)sig;
+	int saved = errno;
+	if (write(hupfd[1], "", 1) == -1) {}	// reloader() does the work
+	errno = saved;
+} // onhup()
+
+void *reloader(void *arg)
+{
+	char c;
+	(void)arg;
+	while (1) {
+		ssize_t got = read(hupfd[0], &c, 1);
+		if (got == -1 && errno == EINTR) continue;
+		if (got != 1) break;
+		if (options_reload() == -1)
+			fputs("Reload failed, options unchanged.\n", stderr);
+	}
+	return NULL;
+} // reloader()
+#endif
+
+#ifdef GENGO_BULK
+/* Bulk parsing. Each record is parsed by process_options() as if it
+ * were the program's own argv, but with OPTBAIL() turning every way out
+ * into an OPTS_* code, and no options from the environment. The argv
+ * getopt_long() permutes is a scratch copy kept from record to record,
+ * optargs are left pointing into the caller's strings.
+*/
+static char **optscratch;
+static size_t optscratchcap;
+
+static int optparseone(int argc, char **argv, options_t *out)
+{	/* Parses the argc words at argv, which is optscratch, into *out,
+	 * zeroed on failure. Returns OPTS_OK or why it failed. */
+	jmp_buf bail;
+	int err = setjmp(bail);
+	if (err == 0) {
+		optbail = &bail;
+		optind = 0;	// getopt_long() starts over.
+		memset(optseen, 0, sizeof optseen);
+		*out = process_options(argc, argv);
+	} else {
+		options_t zero = { 0 };
+		*out = zero;
+	}
+	optbail = NULL;
+	optpartial = NULL;
+	return err;
+} // optparseone()
+
+static int optscratchfit(size_t n)
+{	/* Room for n words and a NULL in optscratch, -1 if there is none. */
+	if (n + 1 <= optscratchcap) return 0;
+	size_t cap = (optscratchcap) ? 2 * optscratchcap : 64;
+	while (cap < n + 1) cap *= 2;
+	char **p = (char **)realloc(optscratch, cap * sizeof(char *));
+	if (!p) return -1;
+	optscratch = p;
+	optscratchcap = cap;
+	return 0;
+} // optscratchfit()
+
+size_t options_parse_argvs(char **const *argvs, size_t n, options_t *out,
+							int *errs)
+{	/* Parses the n NULL terminated argvs, argv[0] first, into out[0]
+	 * to out[n - 1], never exiting. errs[i] is OPTS_OK or why argvs[i]
+	 * failed, out[i] is zeroed then. Returns the number parsed OK.
+	 * Not reentrant, getopt_long() is not.
+	*/
+	size_t i, ok = 0;
+	for (i = 0; i < n; i++) {
+		size_t argc = 0;
+		while (argvs[i][argc]) argc++;
+		if (optscratchfit(argc) == -1) {
+			options_t zero = { 0 };
+			out[i] = zero;
+			errs[i] = OPTS_NOMEM;
+			continue;
+		}
+		memcpy(optscratch, argvs[i], (argc + 1) * sizeof(char *));
+		errs[i] = optparseone((int)argc, optscratch, &out[i]);
+		if (errs[i] == OPTS_OK) ok++;
+	}
+	return ok;
+} // options_parse_argvs()
+
+size_t options_parse_records(char **bufp, char *end, options_t *out,
+								int *errs, size_t max)
+{	/* Parses up to max records from *bufp..end into out[] and errs[] as
+	 * options_parse_argvs() does, and returns how many. A record is its
+	 * words, argv[0] first, each '\0' terminated, then an empty word.
+	 * *bufp is left at the first record not parsed, a record that is
+	 * not complete before end is left for the next call.
+	*/
+	char *cp = *bufp;
+	size_t nrec = 0;
+	while (nrec < max && cp < end) {
+		char *rec = cp;
+		size_t argc = 0;
+		int full = 0;
+		while (cp < end) {
+			char *eow = (char *)memchr(cp, '\0', end - cp);
+			if (!eow) break;
+			if (eow == cp) {	// the empty word ends the record.
+				full = 1;
+				cp++;
+				break;
+			}
+			if (optscratchfit(argc + 1) == 0) optscratch[argc] = cp;
+			argc++;
+			cp = eow + 1;
+		}
+		if (!full) {
+			cp = rec;
+			break;
+		}
+		if (argc + 1 > optscratchcap) {
+			options_t zero = { 0 };
+			out[nrec] = zero;
+			errs[nrec++] = OPTS_NOMEM;
+			continue;
+		}
+		optscratch[argc] = NULL;
+		errs[nrec] = optparseone((int)argc, optscratch, &out[nrec]);
+		nrec++;
+	}
+	*bufp = cp;
+	return nrec;
+} // options_parse_records()
+#endif
+
+#ifdef GENGO_PROFILE
+/* How often each option is used, for gengo -g --profile. Appended at
+ * exit to $GENGO_PROFILE, default gengo.prof, 1 "--name count" or
+ * "-c count" line per option used. */
+static struct {
+	const char *name;	// long name, or NULL
+	int c;	// the option char
+	unsigned long n;
+} gprof[256];
+static int ngprof;
+
+static void gengo_profile_write(void);
+
+void gengo_profile_count(int opt, const struct option *lo, int index)
+{	/* Counts a use of the option getopt_long() returned, by its long
+	 * name if it has one, and sets gengo_profile_write() to run at
+	 * exit the first time. */
+	const char *name = NULL;
+	int i;
+	if (opt == '?' || opt == ':') return;
+	if (opt == 0) name = lo[index].name;
+	for (i = 0; !name && lo[i].name; i++) {
+		if (!lo[i].flag && lo[i].val == opt) name = lo[i].name;
+	}
+	for (i = 0; i < ngprof; i++) {
+		if (gprof[i].name == name && gprof[i].c == opt) break;
+	}
+	if (i == ngprof) {
+		if (ngprof == 256) return;
+		if (ngprof == 0) atexit(gengo_profile_write);
+		gprof[i].name = name;
+		gprof[i].c = opt;
+		ngprof++;
+	}
+	gprof[i].n++;
+} // gengo_profile_count()
+
+void gengo_profile_write(void)
+{	/* Appends the counts to $GENGO_PROFILE or gengo.prof. */
+	const char *path = getenv("GENGO_PROFILE");
+	FILE *fp = fopen((path) ? path : "gengo.prof", "a");
+	int i;
+	if (!fp) return;
+	for (i = 0; i < ngprof; i++) {
+		if (gprof[i].name)
+			fprintf(fp, "--%s %lu\n", gprof[i].name, gprof[i].n);
+		else
+			fprintf(fp, "-%c %lu\n", gprof[i].c, gprof[i].n);
+	}
+	fclose(fp);
+} // gengo_profile_write()
+#endif
+
+#ifdef GENGO_TRACE
+gengo_trace gtrace;
+
+void gengo_trace_mark(int phase)
+{	/* Records the time phase is reached, and fires the USDT probe. */
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	gtrace.ns[phase] = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#ifdef GENGO_TRACE_USDT
+	DTRACE_PROBE2(gengo, phase, phase, gtrace.ns[phase]);
+#endif
+} // gengo_trace_mark()
+
+void gengo_trace_report(void)
+{	/* The phase times and counts, to stderr or the USDT probe. */
+#ifdef GENGO_TRACE_USDT
+	DTRACE_PROBE3(gengo, counts, gtrace.options, gtrace.conversions,
+					gtrace.allocs);
+#else
+	fprintf(stderr, "gengo trace: defaults %llu ns, options %llu ns, "
+	"positionals %llu ns; %u options, %u conversions, %u allocs\n",
+	gtrace.ns[GT_DEFAULTS] - gtrace.ns[GT_START],
+	gtrace.ns[GT_PARSE] - gtrace.ns[GT_DEFAULTS],
+	gtrace.ns[GT_POSITIONAL] - gtrace.ns[GT_PARSE],
+	gtrace.options, gtrace.conversions, gtrace.allocs);
+#endif
+} // gengo_trace_report()
+#endif
+#ifdef GENGO_BULK
+#undef strdup
+#endif
 //</tail>
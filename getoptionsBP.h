@@ -22,26 +22,90 @@
 #ifndef _GETOPTIONS_H
 #define _GETOPTIONS_H
 #define _GNU_SOURCE 1
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdarg.h>
-#include <unistd.h>
-#include <getopt.h>
-#include <ctype.h>
-#include <limits.h>
-#include <linux/limits.h>
-#include <libgen.h>
+/* Only what options_t and the prototypes need, the rest is included
+ * by getoptions.c. gengo adds the headers for the user's types. */
+#include <stddef.h>
+//</preamble>
+//<optionstype>
 
+/* An option given any number of times, each optarg in command line
+ * order with a NULL after the last. */
+typedef struct optlist {
+	char **v;
+	size_t n;	// optargs in v
+	size_t cap;	// room in v
+} optlist;
+void optlistpush(optlist *l, char *s);
 
 /* user declarations */
 typedef struct options_ {
-//</preamble>
-//<tail>
+//</optionstype>
+//<optionsend>
 } options_t;
+//</optionsend>
+//<tail>
 
 void dohelp(int forced);
 options_t process_options(int argc, char **argv);
+int checkargs(int argc, char **argv, int first, const char *kinds);
+void options_dispose(options_t *opts);
+
+#if defined(GENGO_RELOAD) && !defined(GENGO_SERIAL)
+#define GENGO_SERIAL	// options_reload() passes the options through it.
+#endif
+#ifdef GENGO_SERIAL
+/* Serialization, compiled in with -DGENGO_SERIAL. */
+size_t options_serialize(const options_t *opts, char *buf, size_t size);
+int options_deserialize(options_t *opts, char *buf, size_t len);
+size_t options_size(const char *buf);
+void options_convert(options_t *opts);	// runs every opt_<var>()
+#endif
+
+#ifdef GENGO_RELOAD
+/* Hot reload on SIGHUP, compiled in with -DGENGO_RELOAD and linked
+ * with -lpthread. */
+void options_reload_init(const options_t *opts, int argc, char **argv,
+							const char *config);
+int options_reload(void);
+const options_t *options_acquire(int *token);
+void options_release(int token);
+#endif
+
+#ifdef GENGO_BULK
+/* Bulk parsing, compiled in with -DGENGO_BULK, for checking many
+ * command lines in process. Nothing is printed, nothing exits. The
+ * strings of out[i] point into the caller's, which must outlive it,
+ * options_dispose(&out[i]) frees its lists. */
+enum { OPTS_OK, OPTS_HELP, OPTS_NOARG, OPTS_UNKNOWN, OPTS_RULE, OPTS_BAD,
+	OPTS_NOMEM };
+size_t options_parse_argvs(char **const *argvs, size_t n, options_t *out,
+							int *errs);
+size_t options_parse_records(char **bufp, char *end, options_t *out,
+								int *errs, size_t max);
+#endif
+
+#ifdef GENGO_TRACE
+/* Parse time instrumentation, compiled in with -DGENGO_TRACE. Add
+ * -DGENGO_TRACE_USDT to fire <sys/sdt.h> probes instead of reporting
+ * on stderr. */
+enum { GT_START, GT_DEFAULTS, GT_PARSE, GT_POSITIONAL, GT_NPHASES };
+typedef struct gengo_trace {
+	unsigned long long ns[GT_NPHASES];	// CLOCK_MONOTONIC at each phase
+	unsigned options;	// options seen
+	unsigned conversions;	// optargs converted
+	unsigned allocs;	// optargs copied to the heap
+} gengo_trace;
+extern gengo_trace gtrace;
+void gengo_trace_mark(int phase);
+void gengo_trace_report(void);
+#define GTRACE_MARK(phase)	gengo_trace_mark(phase)
+#define GTRACE_COUNT(what)	(gtrace.what++)
+#define GTRACE_REPORT()	gengo_trace_report()
+#else
+#define GTRACE_MARK(phase)	((void)0)
+#define GTRACE_COUNT(what)	((void)0)
+#define GTRACE_REPORT()	((void)0)
+#endif
 
 #endif
 //</tail>
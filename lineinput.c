@@ -0,0 +1,113 @@
+/* lineinput.c
+ *
+ * Copyright 2015 Bob Parker <rlp1938@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+*/
+
+/* All of the user's answers are read 1 line at a time through here.
+ * A terminal gets readline(), anything else is read through 1 buffer
+ * so that a read() which returns several lines loses none of them.
+ * Every answer may be recorded to a transcript, and a transcript may
+ * be replayed in place of the user.
+*/
+
+#include <stdio.h>
+#include <readline/readline.h>
+#include "fileops.h"
+#include "lineinput.h"
+
+static int infd;	// 0 or the transcript being replayed.
+static int usereadline;
+static FILE *fprec;	// transcript being recorded.
+static char inbuf[PATH_MAX];
+static size_t inhead, intail;	// unread data in inbuf.
+static char line[PATH_MAX];
+
+static int bufline(void);
+
+void inputinit(const char *recordfile, const char *replayfile)
+{
+	infd = 0;
+	if (replayfile) {
+		infd = open(replayfile, O_RDONLY);
+		if (infd == -1) {
+			perror(replayfile);
+			exit(EXIT_FAILURE);
+		}
+	}
+	usereadline = (infd == 0 && isatty(0));
+	if (recordfile) fprec = dofopen(recordfile, "w");
+} // inputinit()
+
+char *inputline(const char *prompt)
+{
+	/* Shows prompt unless replaying, and returns the next line of input
+	 * without its '\n', or NULL at end of input. The line is
+	 * overwritten by the next call.
+	*/
+	fflush(stdout);	// keep earlier output ahead of the prompt.
+	if (usereadline) {
+		char *buf = readline(prompt);
+		if (!buf) return NULL;
+		snprintf(line, PATH_MAX, "%s", buf);
+		free(buf);
+	} else {
+		if (infd == 0 && prompt) dowrite(1, (char *)prompt);
+		if (bufline() == -1) return NULL;
+	}
+	if (fprec) {
+		fprintf(fprec, "%s\n", line);
+		fflush(fprec);
+	}
+	return line;
+} // inputline()
+
+int bufline(void)
+{
+	/* Moves the next line in inbuf to line, refilling inbuf as needed.
+	 * Lines too long for inbuf are split. Returns -1 at end of input.
+	*/
+	while (1) {
+		char *eol = memchr(inbuf + inhead, '\n', intail - inhead);
+		int full = (inhead == 0 && intail == PATH_MAX);
+		if (eol || full) {
+			size_t len = (eol) ? (size_t)(eol - (inbuf + inhead))
+								: intail - inhead - 1;
+			memcpy(line, inbuf + inhead, len);
+			line[len] = '\0';
+			inhead += (eol) ? len + 1 : len;
+			return 0;
+		}
+		// no complete line, move the part line down and read more.
+		memmove(inbuf, inbuf + inhead, intail - inhead);
+		intail -= inhead;
+		inhead = 0;
+		ssize_t res = read(infd, inbuf + intail, PATH_MAX - intail);
+		if (res == -1) {
+			perror("read");
+			exit(EXIT_FAILURE);
+		}
+		if (res == 0) {	// end of input, maybe without a last '\n'.
+			if (intail == 0) return -1;
+			memcpy(line, inbuf, intail);
+			line[intail] = '\0';
+			inhead = intail = 0;
+			return 0;
+		}
+		intail += res;
+	}
+} // bufline()
@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <getopt.h>
 #include "getoptions.h"
@@ -33,6 +34,8 @@ int main(int argc, char **argv)
 /* process non-option arguments */
 //</preamble>
 //<tail>
+	GTRACE_MARK(GT_POSITIONAL);
+	GTRACE_REPORT();
 	return 0;
 } //main()
 //</tail>
@@ -0,0 +1,40 @@
+//<preamble>
+/* main.cpp
+ *
+ * Copyright 2015 Bob Parker <rlp1938@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <getopt.h>
+#include "getoptions.hpp"
+
+int main(int argc, char **argv)
+{
+	options_t opts = process_options(argc, argv);
+
+/* process non-option arguments */
+//</preamble>
+//<tail>
+	GTRACE_MARK(GT_POSITIONAL);
+	GTRACE_REPORT();
+	return 0;
+} //main()
+//</tail>
@@ -0,0 +1,138 @@
+/* stats.c
+ *
+ * Copyright 2015 Bob Parker <rlp1938@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include "stats.h"
+
+#define MAXPHASES	64
+
+typedef struct phase {
+	char name[80];
+	double secs;
+	iostats io;
+} phase;
+
+iostats iocount;
+
+static int statskind;
+static phase phases[MAXPHASES];
+static int nphases;
+static struct timespec t0;
+static iostats io0;
+
+static double elapsed(const struct timespec *from);
+static void jsonstr(FILE *fpo, const char *s);
+
+void statsinit(int kind)
+{
+	statskind = kind;
+	nphases = 0;
+} // statsinit()
+
+void statsbegin(const char *fmt, ...)
+{
+	/* Starts timing a named phase, the name is a printf format.
+	 * Does nothing unless statsinit() asked for a report.
+	*/
+	if (statskind == STATS_NONE || nphases == MAXPHASES) return;
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(phases[nphases].name, sizeof phases[nphases].name, fmt,
+				ap);
+	va_end(ap);
+	io0 = iocount;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+} // statsbegin()
+
+void statsend(void)
+{
+	/* Records the time and i/o of the phase begun by statsbegin(). */
+	if (statskind == STATS_NONE || nphases == MAXPHASES) return;
+	phase *ph = &phases[nphases];
+	ph->secs = elapsed(&t0);
+	ph->io.opens = iocount.opens - io0.opens;
+	ph->io.writes = iocount.writes - io0.writes;
+	ph->io.bytesread = iocount.bytesread - io0.bytesread;
+	ph->io.byteswritten = iocount.byteswritten - io0.byteswritten;
+	nphases++;
+} // statsend()
+
+void statsreport(FILE *fpo)
+{
+	/* Writes the recorded phases and their totals to fpo. */
+	if (statskind == STATS_NONE) return;
+	phase total;
+	memset(&total, 0, sizeof total);
+	strcpy(total.name, "total");
+	int i;
+	if (statskind == STATS_JSON) fputs("{\"phases\": [\n", fpo);
+	else fprintf(fpo, "%-40s %10s %9s %9s %5s %6s\n", "phase", "usecs",
+					"read", "written", "opens", "writes");
+	for (i = 0; i <= nphases; i++) {
+		phase *ph = (i < nphases) ? &phases[i] : &total;
+		if (i == nphases && statskind == STATS_JSON)
+			fputs("],\n\"total\":\n", fpo);
+		if (statskind == STATS_JSON) {
+			fputs("  {\"phase\": ", fpo);
+			jsonstr(fpo, ph->name);
+			fprintf(fpo, ", \"usecs\": %.0f, "
+			"\"bytes_read\": %llu, \"bytes_written\": %llu, "
+			"\"opens\": %lu, \"writes\": %lu}%s\n",
+			ph->secs * 1e6, ph->io.bytesread, ph->io.byteswritten,
+			ph->io.opens, ph->io.writes,
+			(i < nphases - 1) ? "," : "");
+		} else {
+			fprintf(fpo, "%-40s %10.0f %9llu %9llu %5lu %6lu\n",
+			ph->name, ph->secs * 1e6, ph->io.bytesread,
+			ph->io.byteswritten, ph->io.opens, ph->io.writes);
+		}
+		if (i < nphases) {
+			total.secs += ph->secs;
+			total.io.opens += ph->io.opens;
+			total.io.writes += ph->io.writes;
+			total.io.bytesread += ph->io.bytesread;
+			total.io.byteswritten += ph->io.byteswritten;
+		}
+	}
+	if (statskind == STATS_JSON) fputs("}\n", fpo);
+} // statsreport()
+
+double elapsed(const struct timespec *from)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - from->tv_sec)
+			+ (now.tv_nsec - from->tv_nsec) / 1e9;
+} // elapsed()
+
+void jsonstr(FILE *fpo, const char *s)
+{	/* Writes s as a JSON string, a phase name may hold a path. */
+	fputc('"', fpo);
+	for (; *s; s++) {
+		unsigned char c = *s;
+		if (c == '"' || c == '\\') fprintf(fpo, "\\%c", c);
+		else if (c < 0x20) fprintf(fpo, "\\u%04x", c);
+		else fputc(c, fpo);
+	}
+	fputc('"', fpo);
+} // jsonstr()
@@ -0,0 +1,201 @@
+/* template.c
+ *
+ * Copyright 2015 Bob Parker <rlp1938@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "template.h"
+
+#define TPLDEPTH	32
+
+static int tplemit(tpl *t, int op);
+static void tplfail(const char *msg, const char *word);
+static const char *tplvalue(const tpl *t, const char *const *globals,
+							const char *const *recs, int rec, int var);
+
+tpl tplcompile(const char *from, const char *to,
+				const char *const *names)
+{
+	/* Compiles the template at from..to, in which {{name}} may be any
+	 * of names, NULL terminated, to its list of ops. The text ops
+	 * point into from..to which must outlive the result. A bad
+	 * template is fatal.
+	*/
+	tpl t = { NULL, 0, 0 };
+	while (names[t.nvars]) t.nvars++;
+	int open[TPLDEPTH], depth = 0, infor = 0;
+	const char *cp = from;
+	while (cp < to) {
+		const char *tag = memmem(cp, to - cp, "{{", 2);
+		const char *tagend = (tag) ? memmem(tag, to - tag, "}}", 2)
+							: NULL;
+		if (!tagend) {
+			int i = tplemit(&t, TPL_TEXT);
+			t.op[i].text = cp;
+			t.op[i].len = to - cp;
+			break;
+		}
+		char word[NAME_MAX];
+		size_t wlen = tagend - tag - 2;
+		if (wlen >= NAME_MAX) tplfail("tag too long", "");
+		memcpy(word, tag + 2, wlen);
+		word[wlen] = '\0';
+		const char *next = tagend + 2;
+		const char *textend = tag;
+		int isvar = strncmp(word, "if ", 3) != 0
+					&& strcmp(word, "else") != 0
+					&& strcmp(word, "end") != 0
+					&& strncmp(word, "for ", 4) != 0;
+		if (!isvar) {	// alone on its line, drop the line.
+			const char *bol = tag;
+			while (bol > from && (bol[-1] == ' ' || bol[-1] == '\t'))
+				bol--;
+			if ((bol == from || bol[-1] == '\n')
+				&& (next == to || *next == '\n')) {
+				textend = bol;
+				if (next < to) next++;
+			}
+		}
+		if (textend > cp) {
+			int i = tplemit(&t, TPL_TEXT);
+			t.op[i].text = cp;
+			t.op[i].len = textend - cp;
+		}
+		cp = next;
+		if (strncmp(word, "if ", 3) == 0) {
+			char *name = word + 3;
+			int i = tplemit(&t, TPL_IF);
+			t.op[i].neg = (*name == '!');
+			name += t.op[i].neg;
+			for (t.op[i].var = 0; names[t.op[i].var]
+					&& strcmp(names[t.op[i].var], name) != 0;
+					t.op[i].var++) ;
+			if (!names[t.op[i].var]) tplfail("no such variable", name);
+			if (depth == TPLDEPTH) tplfail("too deep", word);
+			open[depth++] = i;
+		} else if (strcmp(word, "else") == 0) {
+			if (!depth || t.op[open[depth - 1]].op != TPL_IF)
+				tplfail("{{else}} without {{if}}", "");
+			int i = tplemit(&t, TPL_ELSE);
+			t.op[open[depth - 1]].jump = i + 1;
+			open[depth - 1] = i;
+		} else if (strncmp(word, "for ", 4) == 0) {
+			if (infor) tplfail("{{for}} inside {{for}}", "");
+			if (depth == TPLDEPTH) tplfail("too deep", word);
+			infor = 1;
+			open[depth++] = tplemit(&t, TPL_FOR);
+		} else if (strcmp(word, "end") == 0) {
+			if (!depth) tplfail("{{end}} without {{if}} or {{for}}", "");
+			int start = open[--depth];
+			if (t.op[start].op == TPL_FOR) {
+				int i = tplemit(&t, TPL_END);
+				t.op[i].jump = start + 1;
+				infor = 0;
+			}
+			t.op[start].jump = t.nop;
+		} else {
+			int i = tplemit(&t, TPL_VAR);
+			for (t.op[i].var = 0; names[t.op[i].var]
+					&& strcmp(names[t.op[i].var], word) != 0;
+					t.op[i].var++) ;
+			if (!names[t.op[i].var]) tplfail("no such variable", word);
+		}
+	}
+	if (depth) tplfail("{{if}} or {{for}} without {{end}}", "");
+	return t;
+} // tplcompile()
+
+void tplrender(const tpl *t, FILE *fpo, const char *const *globals,
+				const char *const *recs, int nrecs)
+{
+	/* Writes t to fpo. globals, which may be NULL, holds a value for
+	 * each of the names t was compiled with, and recs nrecs records of
+	 * as many, the values in the {{for}} loop. A NULL value is empty,
+	 * one in a record is taken from globals.
+	*/
+	int pc, rec = -1;
+	for (pc = 0; pc < t->nop; pc++) {
+		const tplop *op = &t->op[pc];
+		const char *val;
+		switch (op->op) {
+			case TPL_TEXT:
+				fwrite(op->text, 1, op->len, fpo);
+				break;
+			case TPL_VAR:
+				val = tplvalue(t, globals, recs, rec, op->var);
+				if (val) fputs(val, fpo);
+				break;
+			case TPL_IF:
+				val = tplvalue(t, globals, recs, rec, op->var);
+				if ((!val || !*val) != op->neg) pc = op->jump - 1;
+				break;
+			case TPL_ELSE:
+				pc = op->jump - 1;
+				break;
+			case TPL_FOR:
+				if (nrecs) rec = 0;
+				else pc = op->jump - 1;
+				break;
+			case TPL_END:
+				if (++rec < nrecs) pc = op->jump - 1;
+				else rec = -1;
+				break;
+		}
+	}
+} // tplrender()
+
+void tplfree(tpl *t)
+{
+	/* Frees the ops of t. */
+	free(t->op);
+	t->op = NULL;
+	t->nop = 0;
+} // tplfree()
+
+int tplemit(tpl *t, int op)
+{
+	/* Appends a zeroed op to t, returns its index. */
+	if ((t->nop & (t->nop - 1)) == 0) {	// 0 or a power of 2, grow.
+		t->op = realloc(t->op, ((t->nop) ? 2 * t->nop : 1)
+							* sizeof(tplop));
+		if (!t->op) {
+			perror("tplemit");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memset(&t->op[t->nop], 0, sizeof(tplop));
+	t->op[t->nop].op = op;
+	return t->nop++;
+} // tplemit()
+
+void tplfail(const char *msg, const char *word)
+{	/* Reports a bad template and exits. */
+	fprintf(stderr, "template: %s %s\n", msg, word);
+	exit(EXIT_FAILURE);
+} // tplfail()
+
+const char *tplvalue(const tpl *t, const char *const *globals,
+						const char *const *recs, int rec, int var)
+{
+	/* The value of variable var in record rec, or in globals. */
+	const char *val = (rec >= 0) ? recs[rec * t->nvars + var] : NULL;
+	if (!val && globals) val = globals[var];
+	return val;
+} // tplvalue()
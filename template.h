@@ -0,0 +1,56 @@
+/*
+ * template.h
+ * Copyright 2015 Bob Parker <rlp1938@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+*/
+
+#ifndef _TEMPLATE_H
+#define _TEMPLATE_H
+#include <stdio.h>
+
+/* A template is text with {{name}} for the value of a variable,
+ * {{if name}} or {{if !name}}, {{else}} and {{end}} around text wanted
+ * only when the value is, or is not, empty, and {{for what}} and
+ * {{end}} around text wanted once per record, what naming whatever
+ * the records are, option or tool. A tag other than
+ * {{name}} alone on its line takes the line with it.
+ * tplcompile() makes the list of ops once, tplrender() runs it in 1
+ * pass over the records. */
+enum { TPL_TEXT, TPL_VAR, TPL_IF, TPL_ELSE, TPL_FOR, TPL_END };
+
+typedef struct tplop {
+	int op;	// TPL_*
+	int var;	// TPL_VAR and TPL_IF, index into the names
+	int neg;	// TPL_IF, wants the value empty
+	int jump;	// TPL_IF, TPL_ELSE and TPL_FOR past, TPL_END back
+	const char *text;	// TPL_TEXT, in the compiled from..to
+	size_t len;
+} tplop;
+
+typedef struct tpl {
+	tplop *op;
+	int nop;
+	int nvars;	// names, so values per record
+} tpl;
+
+tpl tplcompile(const char *from, const char *to,
+				const char *const *names);
+void tplrender(const tpl *t, FILE *fpo, const char *const *globals,
+				const char *const *recs, int nrecs);
+void tplfree(tpl *t);
+
+#endif